@@ -47,6 +47,10 @@
 //     scutl: test.c++:16:two_times_two: ERROR: REQUIRE(x == 2)
 //     scutl: SUMMARY: |count   |started |complete|passed  |failed  |aborted |
 //     scutl: SUMMARY: |       3|       3|       3|       1|       2|       1|
+//     scutl: TIME: 41.2us total
+//     scutl: SLOWEST: 17.9us test.c++:16:two_times_two
+//     scutl: SLOWEST: 12.6us test.c++:11:one_plus_one
+//     scutl: SLOWEST: 1.08us test.c++:6:one_equals_one
 //
 // Whoops! Looks like something wasn't quite right with our code. Fortunately,
 // it should now be easy to go fix those bugs with confidence!
@@ -103,6 +107,58 @@
 //
 // Default_Reporter -- writes test log to stdout and errors/summary to stderr
 // TAP_Reporter     -- writes Test Anything Protocol format to stdout
+// JSON_Reporter    -- writes one JSON object per event (JSON Lines) to stdout
+//
+// SCUTL_ASYNC:
+//
+//     #define SCUTL_ASYNC
+//     #include <scutl.h++>
+//
+// When SCUTL_ASYNC is defined, the main implementation provided by SCUTL_MAIN
+// wraps its reporter in a scutl::Async_Reporter, as described in the section
+// on custom reporters below, so that writing the results happens on a
+// background thread instead of holding up the tests.
+//
+// SCUTL_JOBS:
+//
+//     #define SCUTL_JOBS 8
+//     #include <scutl.h++>
+//
+// When SCUTL_JOBS is set, the main implementation provided by SCUTL_MAIN runs
+// tests on that many worker threads instead of one at a time. A value of 0
+// uses one worker per hardware thread. See the section on running tests in
+// parallel below before turning this on.
+//
+// SCUTL_ISOLATE & SCUTL_TIMEOUT:
+//
+//     #define SCUTL_ISOLATE
+//     #define SCUTL_TIMEOUT 30
+//     #include <scutl.h++>
+//
+// When SCUTL_ISOLATE is defined, the main implementation provided by
+// SCUTL_MAIN runs tests in worker processes, as described in the section on
+// isolating tests below. SCUTL_TIMEOUT sets how many seconds an isolated test
+// may run before it is killed.
+//
+// SCUTL_TIMING_CACHE:
+//
+//     #define SCUTL_TIMING_CACHE "scutl_timings.txt"
+//     #include <scutl.h++>
+//
+// When SCUTL_TIMING_CACHE is set to a file name, the main implementation
+// provided by SCUTL_MAIN uses that file as its timing cache, as described in
+// the section on test timing below.
+//
+// SCUTL_ALLOCATIONS:
+//
+//     #define SCUTL_ALLOCATIONS
+//     #define SCUTL_MAIN
+//     #include <scutl.h++>
+//
+// When SCUTL_ALLOCATIONS is defined in the same file as SCUTL_LIBRARY or
+// SCUTL_MAIN, scutl replaces the global operator new and delete with versions
+// that count each test's allocations, as described in the section on
+// tracking allocations below.
 //
 // Including The Library
 // ---------------------
@@ -119,6 +175,12 @@
 // recommended to use the appropriate compiler flags (such as -I for gcc) to
 // make this syntax work either way.
 //
+// Scutl is careful to include only the few standard headers its public API
+// needs, leaving heavier ones like <iostream> to the one file that defines
+// SCUTL_LIBRARY or SCUTL_MAIN. This keeps files full of tests quick to
+// compile, but it does mean those files should include whatever standard
+// headers they use themselves.
+//
 // Creating Tests & Using Fixtures
 // -------------------------------
 //
@@ -162,6 +224,37 @@
 // between mulitple tests. Because each test runs with a new copy of the
 // fixture, tests do not interfere with each other.
 //
+// TEST_SUITE_METHOD & SUITE_FIXTURE:
+//
+//     struct Database {
+//         Database() { /* load a huge data set */ }
+//         size_t count(const char *table) const;
+//     };
+//
+//     struct Query_Fixture {
+//         Query_Fixture() : database(SUITE_FIXTURE(Database)) {}
+//         const Database &database;
+//     };
+//
+//     TEST_SUITE_METHOD(Database, Query_Fixture, has_users) {
+//         EXPECT(database.count("users") > 0);
+//     }
+//
+// Some setup is too expensive to repeat for every test. TEST_SUITE_METHOD
+// works just like TEST_METHOD, but also puts the test in the suite of tests
+// sharing a single instance of the given suite fixture class, which any of
+// them can get at as a const reference with SUITE_FIXTURE. The suite fixture
+// is created when the first test of the suite runs, and destroyed as soon as
+// the last one has finished; to help with that, scutl runs the tests of each
+// suite together, right where its first test would have run. If creating the
+// suite fixture fails, every test in the suite fails with the reason, without
+// trying to create it again. The tests of a suite run one after another on a
+// single worker, but they should still only read from the fixture they share,
+// so that they don't depend on each other. Only the tests of the suite may
+// use it; SUITE_FIXTURE fails any other test. Like any destructor, the suite
+// fixture's shouldn't throw. (When tests are isolated, each worker process
+// creates its own suite fixture.)
+//
 // Using Assertions in Tests
 // -------------------------
 //
@@ -193,6 +286,65 @@
 // the current test is aborted. This assertion is used when an assertion
 // failure implies that the current test should not even attempt to continue.
 //
+// EXPECT_RANGE_EQ, EXPECT_NEAR_RANGE & EXPECT_ALL:
+//
+//     EXPECT_RANGE_EQ(output, expected_output);
+//     EXPECT_NEAR_RANGE(samples, reference_samples, 1e-6);
+//     EXPECT_ALL(weights, [](double w) { return w >= 0; });
+//
+// These assertions check every element of a range in one pass and report at
+// most a single error, naming how many elements failed, the first of them,
+// and the values involved (when they're numbers), rather than one error per
+// element. The ranges can be arrays, containers, or anything else with
+// begin() and end(), and ranges with data() and size() are compared with
+// tight loops (or memcmp) that stay fast even for millions of elements.
+// REQUIRE_RANGE_EQ, REQUIRE_NEAR_RANGE, and REQUIRE_ALL abort the test on a
+// failure, just like REQUIRE.
+//
+// A test that loops over a big data set with plain EXPECT can still report a
+// flood of errors. The --max-errors=N option caps how many each test reports;
+// further failures still fail the test, and are summed up in one last error.
+// The failure that aborts a test, such as a REQUIRE, is always reported.
+//
+// Writing Benchmarks
+// ------------------
+//
+// Benchmarks are written just like tests, and are registered and run along
+// with them, but their body is timed instead of being run once:
+//
+// BENCHMARK & BENCHMARK_METHOD:
+//
+//     BENCHMARK(sum_a_vector) {
+//         std::vector<int> data(1024, 1);
+//         int sum = std::accumulate(data.begin(), data.end(), 0);
+//         scutl::do_not_optimize(sum);
+//     }
+//
+//     struct Big_Table {
+//         Big_Table() { /* expensive setup, not timed */ }
+//         Table table;
+//     };
+//
+//     BENCHMARK_METHOD(Big_Table, lookup) {
+//         scutl::set_items_per_iteration(1);
+//         scutl::do_not_optimize(table.lookup(42));
+//     }
+//
+// The fixture of a BENCHMARK_METHOD is constructed once, outside of the timed
+// region. Scutl then picks an iteration count so that each repetition takes
+// about Run_Options::benchmark_time seconds, runs one warmup repetition, and
+// times Run_Options::benchmark_repetitions more. The mean, median, standard
+// deviation, minimum and maximum time per iteration are passed to the
+// reporter, along with items and bytes per second if the body said how many
+// it handles with scutl::set_items_per_iteration and set_bytes_per_iteration.
+// Assertions work in benchmarks too; once one fails, the benchmark stops
+// without a result instead of repeating the failure on every iteration.
+//
+// Optimizing compilers are good at deleting work whose result is never used.
+// Pass such results to scutl::do_not_optimize, and call scutl::clobber_memory
+// where writes to memory must not be optimized away. Since timing is easily
+// disturbed, benchmarks are best run on their own rather than in parallel.
+//
 // Building Test Executables
 // -------------------------
 //
@@ -228,6 +380,32 @@
 //     #include <scutl.h++>
 //     // tests go here in each file
 //
+// Command Line Options
+// --------------------
+//
+// The main implementation accepts a few command line options, which are
+// handy for running part of a large suite. Any plain arguments are globs
+// ('*' matches any run of characters, '?' any single character) selecting
+// which tests to run by name; without any, every test is run.
+//
+//     ./test 'parser_*' --exclude='*_slow' --file='*/parser/*'
+//     ./test --list
+//     ./test --shard=2/8 --jobs=0
+//     ./test one_plus_one --repeat=1000 --fail-fast
+//
+// --list prints the selected tests without running them. --shard=I/N splits
+// the selected tests into N shards and runs only shard I, so that N machines
+// can each run one shard. The split depends only on the tests' files and
+// names, or on their durations when a timing cache is given, in which case
+// shards are balanced by time. Sharded runs only read the timing cache, and
+// every shard must be given an identical copy of it (say, one saved by an
+// unsharded run), or tests may be skipped or run twice. --fail-fast stops
+// at the first failing test, and --repeat=N runs every selected test N times.
+// --max-errors=N reports at most N non-fatal errors from each test. Run the
+// executable with --help to see all of the options. Each option corresponds
+// to a field of scutl::Run_Options, which can be set directly when calling
+// scutl::run.
+//
 // Do It Yourself
 // --------------
 //
@@ -260,6 +438,117 @@
 // your own. The interface for reporters is scutl::Reporter, and is documented
 // fully where it's defined in the header down below.
 //
+// Any reporter, built-in or custom, can be wrapped in a scutl::Async_Reporter:
+//
+//     scutl::JSON_Reporter  json;
+//     scutl::Async_Reporter reporter(json);
+//     bool passed = scutl::run(reporter, options);
+//
+// The wrapper queues each event and returns right away, and a background
+// thread passes the events on to the wrapped reporter in batches, calling its
+// flush function whenever the queue runs dry. Since the wrapped reporter is
+// only ever called from that one thread, it needs no locking of its own. The
+// summary isn't returned from until everything has been written and flushed.
+//
+// JSON_Reporter is meant for tools rather than people. Every event becomes
+// one line holding a JSON object with an "event" field ("count", "started",
+// "error", "benchmark", "complete", or "summary") and the fields of the
+// corresponding scutl struct, so results can be processed as they stream in
+// without parsing the human-readable format. Its output is gathered in a
+// buffer and written out in large chunks.
+//
+// Running Tests In Parallel
+// -------------------------
+//
+// Large suites can spread their tests across several worker threads by
+// passing a scutl::Run_Options to scutl::run (or by using SCUTL_JOBS with
+// SCUTL_MAIN):
+//
+//     scutl::Default_Reporter reporter;
+//     scutl::Run_Options options;
+//     options.jobs = 8;
+//     bool passed = scutl::run(reporter, options);
+//
+// Each worker takes tests from its own queue, and steals from the other
+// workers when it runs dry. Tests themselves must be safe to run at the same
+// time as each other, which is usually true of tests that only touch their
+// own fixture. Reporters need not be thread-safe: scutl holds back the events
+// of each test and hands them to the reporter one test at a time, in the same
+// order as a serial run, so the output and statistics are exactly what a
+// serial run would have produced.
+//
+// Test Timing
+// -----------
+//
+// Scutl times every test, including the construction and destruction of its
+// fixture, and passes the duration to reporters in Test_Info. The default
+// reporter ends its summary with the total time taken and a list of the
+// slowest tests, which is the first place to look when a suite gets slow.
+//
+// Setting Run_Options::timing_cache to a file name makes scutl save each
+// test's duration there after every run. The next run reads the file back and
+// hands tests to the workers of a parallel or isolated run longest first,
+// so that a long test isn't started last and left holding up the end of the
+// run. Tests missing from the file are assumed to be long. Results are still
+// reported in the usual order. The file is plain text, with one line per
+// test giving its duration, file and name separated by tabs.
+//
+// Isolating Tests
+// ---------------
+//
+// A test that crashes, aborts, or never finishes would normally take the
+// whole test executable down with it. On POSIX systems, setting the isolate
+// option runs tests in a pool of forked worker processes instead:
+//
+//     scutl::Run_Options options;
+//     options.isolate = true;
+//     options.jobs    = 4;  // Worker processes
+//     options.timeout = 30; // Seconds per test; 0 never times out
+//     bool passed = scutl::run(reporter, options);
+//
+// Workers are handed tests in batches and send their results back to the
+// main process, which reports them in order just like a parallel run. A test
+// that kills its worker is reported as an aborted failure naming the signal
+// (such as "crashed with signal SIGSEGV"), a test that runs past the timeout
+// is killed and reported the same way, and a fresh worker carries on with
+// the remaining tests. Because each test runs in a copy of the main process,
+// changes a test makes to global state are not seen by the main process.
+// Where fork is unavailable, the isolate option is ignored.
+//
+// Tracking Allocations
+// --------------------
+//
+// With SCUTL_ALLOCATIONS defined, every test's Test_Info includes how many
+// allocations it made through operator new, how many bytes they came to, the
+// most bytes it had allocated at once, and how many bytes were still
+// allocated after the test and its fixture were gone, which are most likely
+// leaked. The default reporter shows these in the test log, and the
+// --fail-on-leaks option fails any test that leaks. Allocation assertions
+// then lock in how much a piece of code may allocate:
+//
+//     TEST(lookup_does_not_allocate) {
+//         Table table(1000);
+//         EXPECT_NO_ALLOCATIONS {
+//             table.lookup("key");
+//         }
+//         EXPECT_MAX_ALLOCATIONS(1) {
+//             table.insert("key", 42);
+//         }
+//     }
+//
+// Only the block following the assertion is counted, and it runs just once.
+// The allocations are checked when the block finishes, so leaving it early
+// with break, return or goto skips the check. REQUIRE_NO_ALLOCATIONS and
+// REQUIRE_MAX_ALLOCATIONS abort the test on a failure. Without
+// SCUTL_ALLOCATIONS, these assertions always fail, rather than silently
+// passing.
+//
+// Allocations are counted for the thread running the test, so threads the
+// test starts itself aren't counted, and memory freed on a different thread
+// than it was allocated on is reported as leaked. Memory allocated directly
+// with malloc, or with aligned operator new, isn't counted at all. Counting
+// is cheap, but does add a small header to every allocation.
+//
 // Further API & Implementation Details
 // ------------------------------------
 //
@@ -290,13 +579,18 @@
 #ifndef SCUTL__header__
 #define SCUTL__header__
 
-// Required standard library headers
-#include <iomanip>
-#include <iostream>
-#include <list>
-#include <memory>
-#include <sstream>
+// Required standard library headers. Only what the public API needs is
+// included here, to keep test files quick to compile; the library
+// implementation includes the rest.
+#include <cstddef>
+#include <cstring>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <vector>
+#if !defined(__GNUC__)
+#include <atomic>
+#endif
 
 // Helper macros for concatenation. Two levels of indirection are required in
 // order to expand macros when concatenating. (For instance, this is necessary
@@ -322,6 +616,58 @@
 #error "Scutl wants to provide the TEST_METHOD macro, but it's already defined!"
 #endif
 #define TEST_METHOD(fixture, name)\
+	SCUTL_DETAIL_TEST_METHOD(nullptr, fixture, name, ::scutl::detail::call)
+
+// Define a test method like TEST_METHOD, as part of a suite of tests sharing
+// one instance of the given suite fixture class, available through
+// SUITE_FIXTURE(suite).
+//
+//     TEST_SUITE_METHOD(suite, fixture, name) { body }
+//
+#ifdef TEST_SUITE_METHOD
+#error "Scutl wants to provide the TEST_SUITE_METHOD macro, but it's already defined!"
+#endif
+#define TEST_SUITE_METHOD(suite, fixture, name)\
+	SCUTL_DETAIL_TEST_METHOD(\
+		&::scutl::detail::Suite_Of<suite>::instance, fixture, name, ::scutl::detail::call\
+	)
+
+// Get a const reference to the shared instance of the given suite fixture
+// class, creating it if this is its first use.
+//
+//     SUITE_FIXTURE(suite)
+//
+#ifdef SUITE_FIXTURE
+#error "Scutl wants to provide the SUITE_FIXTURE macro, but it's already defined!"
+#endif
+#define SUITE_FIXTURE(suite) (*static_cast<const suite *>(\
+	::scutl::detail::suite_fixture(::scutl::detail::Suite_Of<suite>::instance, __FILE__, __LINE__)\
+))
+
+// Define a benchmark with the given name and provided body.
+//
+//     BENCHMARK(name) { body }
+//
+#ifdef BENCHMARK
+#error "Scutl wants to provide the BENCHMARK macro, but it's already defined!"
+#endif
+#define BENCHMARK(name) BENCHMARK_METHOD(::scutl::detail::Empty_Fixture, name)
+
+// Define a benchmark method on an instance of the given fixture class with
+// the given name and provided body. The body is what gets timed.
+//
+//     BENCHMARK_METHOD(fixture, name) { body }
+//
+#ifdef BENCHMARK_METHOD
+#error "Scutl wants to provide the BENCHMARK_METHOD macro, but it's already defined!"
+#endif
+#define BENCHMARK_METHOD(fixture, name)\
+	SCUTL_DETAIL_TEST_METHOD(nullptr, fixture, name, ::scutl::detail::benchmark)
+
+// Helper macro for implementing tests and benchmarks. The given runner is
+// called with the fixture-derived function object once it has been created.
+// The suite, if not null, points to the suite the test belongs to.
+#define SCUTL_DETAIL_TEST_METHOD(suite, fixture, name, runner)\
 \
 	/* Enter a uniquified anonymous namespace to avoid conflicts both between\
 	 * tests in a single file, and tests in other files. */\
@@ -329,35 +675,24 @@
 	namespace SCUTL_DETAIL_CONCAT(scutl_detail_line_,__LINE__) {\
 \
 	/* The function is implemented in a class inheriting from the provided\
-	 * fixture class. This is done separately from the Test object to ensure\
+	 * fixture class. This is done separately from the registration to ensure\
 	 * that the user's test function does not have a polluted namespace. */\
 	struct Function : fixture {\
 		void operator()();\
 	};\
 \
-	/* Define our Test class. This calls the user-defined test function when\
-	 * activtated. */\
-	struct Test : ::scutl::detail::Test {\
-		Test() {\
-			/* Set up our Test_Info structure */\
-			info.na##me  = #name;\
-			info.file    = __FILE__;\
-			info.line    = __LINE__;\
-			/* We assume that we have passed until we see a failure */\
-			info.passed  = true;\
-			/* We assume that we have been aborted until we complete */\
-			info.aborted = true;\
-		}\
-		virtual void operator()() {\
-			function.reset(new Function);\
-			function->operator()();\
-			function.reset(nullptr);\
-		};\
-		std::unique_ptr<Function> function;\
-	};\
+	/* Run the user-defined test function on a new copy of the fixture. The\
+	 * names here are reserved, so they don't hide any the test body uses. */\
+	void scutl_detail_run() {\
+		::scutl::detail::Fixture<Function> function;\
+		runner(*function.pointer);\
+	}\
 \
-	/* Create an instance of the test, which will cause auto-registration */\
-	Test test;\
+	/* Register the test. The registration holds only constant data, and is\
+	 * linked into the test list without allocating anything. */\
+	::scutl::detail::Registration scutl_detail_registration(\
+		#name, __FILE__, __LINE__, &scutl_detail_run, suite\
+	);\
 \
 	/* Close the namespaces we opened */\
 	}}\
@@ -367,7 +702,8 @@
 		::Function::operator()()
 
 
-// Helper macro for impementing assertions.
+// Helper macro for impementing assertions. All the work of reporting a
+// failure is done out of line, to keep the code for each assertion small.
 #define SCUTL_DETAIL_ASSERT(expression, assertion, required)\
 \
 	/* Wrap in do/while to give a statement-like interface. */\
@@ -375,29 +711,9 @@
 \
 		/* On a failure, report the results and abort if necessary. */\
 		if (!(expression)) {\
-\
-			/* Collect information about the assertion. */\
-			::scutl::Error_Info error_info;\
-			error_info.requi##red = required;\
-			error_info.expre##ssion = assertion "(" #expression ")";\
-			error_info.file = __FILE__;\
-			error_info.line = __LINE__;\
-\
-			/* Mark current test as failed */\
-			::scutl::detail::global.test->info.passed = false;\
-\
-			/* Report results */\
-			::scutl::detail::global.reporter->report_test_error(\
-				::scutl::detail::global.test->info,\
-				error_info\
+			::scutl::detail::fail(\
+				required, assertion "(" #expression ")", __FILE__, __LINE__\
 			);\
-			/* Throw the error information as an exception to abort the test\
-			 * if this was a required assertion. */\
-			if (required) {\
-				/* Mark current test as aborted */\
-				::scutl::detail::global.test->info.aborted = true;\
-				throw error_info;\
-			}\
 		}\
 	} while(0)
 
@@ -423,17 +739,196 @@
 #endif
 #define REQUIRE(expression) SCUTL_DETAIL_ASSERT(expression, "REQUIRE", true)
 
+// Helper macro for implementing range assertions. The comparison is done in
+// a single pass, and any failure is reported as a single error.
+#define SCUTL_DETAIL_ASSERT_RANGE(comparison, assertion, required)\
+\
+	/* Wrap in do/while to give a statement-like interface. */\
+	do {\
+		::scutl::detail::Range_Comparison scutl_detail_comparison = comparison;\
+\
+		/* On a failure, report the results and abort if necessary. */\
+		if (scutl_detail_comparison.failed()) {\
+			::scutl::detail::fail_range(\
+				required, assertion, __FILE__, __LINE__, scutl_detail_comparison\
+			);\
+		}\
+	} while(0)
+
+// Expect that two ranges have the same size and equal elements.
+//
+//     TEST(name) {
+//         EXPECT_RANGE_EQ(actual, expected);
+//     }
+//
+#ifdef EXPECT_RANGE_EQ
+#error "Scutl wants to provide the EXPECT_RANGE_EQ macro, but it's already defined!"
+#endif
+#define EXPECT_RANGE_EQ(a, b) SCUTL_DETAIL_ASSERT_RANGE(\
+	::scutl::detail::compare_ranges(a, b, ::scutl::detail::Equal()),\
+	"EXPECT_RANGE_EQ(" #a ", " #b ")", false)
+
+// Require that two ranges have the same size and equal elements.
+//
+//     TEST(name) {
+//         REQUIRE_RANGE_EQ(actual, expected);
+//     }
+//
+#ifdef REQUIRE_RANGE_EQ
+#error "Scutl wants to provide the REQUIRE_RANGE_EQ macro, but it's already defined!"
+#endif
+#define REQUIRE_RANGE_EQ(a, b) SCUTL_DETAIL_ASSERT_RANGE(\
+	::scutl::detail::compare_ranges(a, b, ::scutl::detail::Equal()),\
+	"REQUIRE_RANGE_EQ(" #a ", " #b ")", true)
+
+// Expect that two ranges have the same size and elements that differ by no
+// more than the given tolerance.
+//
+//     TEST(name) {
+//         EXPECT_NEAR_RANGE(actual, expected, tolerance);
+//     }
+//
+#ifdef EXPECT_NEAR_RANGE
+#error "Scutl wants to provide the EXPECT_NEAR_RANGE macro, but it's already defined!"
+#endif
+#define EXPECT_NEAR_RANGE(a, b, tolerance) SCUTL_DETAIL_ASSERT_RANGE(\
+	::scutl::detail::compare_ranges(a, b, ::scutl::detail::make_near(tolerance)),\
+	"EXPECT_NEAR_RANGE(" #a ", " #b ", " #tolerance ")", false)
+
+// Require that two ranges have the same size and elements that differ by no
+// more than the given tolerance.
+//
+//     TEST(name) {
+//         REQUIRE_NEAR_RANGE(actual, expected, tolerance);
+//     }
+//
+#ifdef REQUIRE_NEAR_RANGE
+#error "Scutl wants to provide the REQUIRE_NEAR_RANGE macro, but it's already defined!"
+#endif
+#define REQUIRE_NEAR_RANGE(a, b, tolerance) SCUTL_DETAIL_ASSERT_RANGE(\
+	::scutl::detail::compare_ranges(a, b, ::scutl::detail::make_near(tolerance)),\
+	"REQUIRE_NEAR_RANGE(" #a ", " #b ", " #tolerance ")", true)
+
+// Expect that the given predicate is true for every element of a range.
+//
+//     TEST(name) {
+//         EXPECT_ALL(range, predicate);
+//     }
+//
+#ifdef EXPECT_ALL
+#error "Scutl wants to provide the EXPECT_ALL macro, but it's already defined!"
+#endif
+#define EXPECT_ALL(range, predicate) SCUTL_DETAIL_ASSERT_RANGE(\
+	::scutl::detail::check_range(range, predicate),\
+	"EXPECT_ALL(" #range ", " #predicate ")", false)
+
+// Require that the given predicate is true for every element of a range.
+//
+//     TEST(name) {
+//         REQUIRE_ALL(range, predicate);
+//     }
+//
+#ifdef REQUIRE_ALL
+#error "Scutl wants to provide the REQUIRE_ALL macro, but it's already defined!"
+#endif
+#define REQUIRE_ALL(range, predicate) SCUTL_DETAIL_ASSERT_RANGE(\
+	::scutl::detail::check_range(range, predicate),\
+	"REQUIRE_ALL(" #range ", " #predicate ")", true)
+
+// Helper macro for implementing allocation assertions. The block following
+// the macro becomes the body of a loop that runs exactly once, counting the
+// allocations it makes, and checking them once it's done. A break or return
+// in the block leaves the loop without checking.
+#define SCUTL_DETAIL_ASSERT_ALLOCATIONS(limit, assertion, required)\
+	for (\
+		::scutl::detail::Allocation_Scope scutl_detail_scope(\
+			limit, assertion, required, __FILE__, __LINE__\
+		);\
+		scutl_detail_scope.next();\
+	)
+
+// Expect that a block of code makes at most the given number of allocations.
+//
+//     TEST(name) {
+//         EXPECT_MAX_ALLOCATIONS(1) {
+//             // code to check
+//         }
+//     }
+//
+#ifdef EXPECT_MAX_ALLOCATIONS
+#error "Scutl wants to provide the EXPECT_MAX_ALLOCATIONS macro, but it's already defined!"
+#endif
+#define EXPECT_MAX_ALLOCATIONS(limit) SCUTL_DETAIL_ASSERT_ALLOCATIONS(\
+	limit, "EXPECT_MAX_ALLOCATIONS(" #limit ")", false)
+
+// Require that a block of code makes at most the given number of allocations.
+//
+//     TEST(name) {
+//         REQUIRE_MAX_ALLOCATIONS(1) {
+//             // code to check
+//         }
+//     }
+//
+#ifdef REQUIRE_MAX_ALLOCATIONS
+#error "Scutl wants to provide the REQUIRE_MAX_ALLOCATIONS macro, but it's already defined!"
+#endif
+#define REQUIRE_MAX_ALLOCATIONS(limit) SCUTL_DETAIL_ASSERT_ALLOCATIONS(\
+	limit, "REQUIRE_MAX_ALLOCATIONS(" #limit ")", true)
+
+// Expect that a block of code makes no allocations.
+//
+//     TEST(name) {
+//         EXPECT_NO_ALLOCATIONS {
+//             // code to check
+//         }
+//     }
+//
+#ifdef EXPECT_NO_ALLOCATIONS
+#error "Scutl wants to provide the EXPECT_NO_ALLOCATIONS macro, but it's already defined!"
+#endif
+#define EXPECT_NO_ALLOCATIONS SCUTL_DETAIL_ASSERT_ALLOCATIONS(\
+	0, "EXPECT_NO_ALLOCATIONS", false)
+
+// Require that a block of code makes no allocations.
+//
+//     TEST(name) {
+//         REQUIRE_NO_ALLOCATIONS {
+//             // code to check
+//         }
+//     }
+//
+#ifdef REQUIRE_NO_ALLOCATIONS
+#error "Scutl wants to provide the REQUIRE_NO_ALLOCATIONS macro, but it's already defined!"
+#endif
+#define REQUIRE_NO_ALLOCATIONS SCUTL_DETAIL_ASSERT_ALLOCATIONS(\
+	0, "REQUIRE_NO_ALLOCATIONS", true)
+
 // Functions & classes in the public API
 namespace scutl {
 
+	// Memory a test allocated with operator new on the thread running it.
+	// This is only tracked when SCUTL_ALLOCATIONS is defined; otherwise
+	// tracked is false and the rest is zero.
+	struct Allocation_Info {
+		bool   tracked;      // Allocations were tracked for this test
+		size_t count;        // Allocations made
+		size_t bytes;        // Bytes allocated in total
+		size_t peak_bytes;   // Most bytes allocated and not yet freed at once
+		size_t leaked_bytes; // Bytes still allocated after the test finished
+	};
+
 	// Information about a test. This is used in the implementation, but is
 	// part of the public API because it used by the reporter interface.
 	struct Test_Info {
 		std::string name;    // From TEST(name)
 		std::string file;    // Filename from __FILE__
 		size_t      line;    // Line from __LINE__
-		bool        passed;  // Test passed; only valid after completion
-		bool        aborted; // Test aborted; only valid after completion
+		bool        passed;   // Test passed; only valid after completion
+		bool        aborted;  // Test aborted; only valid after completion
+		double      duration; // Seconds taken; only valid after completion
+
+		// Allocations made by the test; only valid after completion
+		Allocation_Info allocations;
 	};
 
 	// Information about a failing assertion. This is used by the
@@ -457,10 +952,26 @@ namespace scutl {
 		size_t passed;   // Tests that passed
 		size_t failed;   // Tested that failed. (passed + failed == complete)
 		size_t aborted;  // Tests that were aborted; a subset of failed
+		double duration; // Wall time in seconds taken to run all the tests
+	};
+
+	// Timing results from a benchmark. All times are in seconds per
+	// iteration of the benchmark body.
+	struct Benchmark_Result {
+		size_t iterations;       // Iterations timed in each repetition
+		size_t repetitions;      // Timed repetitions, not counting warmup
+		double mean;             // Mean time over all repetitions
+		double median;           // Median time over all repetitions
+		double stddev;           // Sample standard deviation of the times
+		double min;              // Fastest repetition
+		double max;              // Slowest repetition
+		double items_per_second; // From set_items_per_iteration, or 0
+		double bytes_per_second; // From set_bytes_per_iteration, or 0
 	};
 
 	// Abstract interface for reporters of test results. Both built-in and
-	// custom reporters must implement all of these virtual functions.
+	// custom reporters must implement all of these virtual functions, except
+	// where noted.
 	struct Reporter {
 		Reporter() {}
 		virtual ~Reporter() {}
@@ -489,22 +1000,39 @@ namespace scutl {
 		// not valid at this point!)
 		virtual void report_test_error   (const Test_Info &, const Error_Info &) = 0;
 
+		// Called when a benchmark has finished timing, between
+		// report_test_started and report_test_complete. Benchmarks are run
+		// as tests, so they are also counted in the test statistics.
+		// Implementing this is optional; by default results are ignored.
+		virtual void report_benchmark_result(const Test_Info &, const Benchmark_Result &) {}
+
 		// Called after all tests have been run, in order to summarize all of
 		// the results. The reporter could have collected this information,
 		// but by providing this functionality, reporters are simpler and
 		// easier to create.
 		virtual void report_test_summary (const Test_Statistics &) = 0;
+
+		// Called when any output the reporter has buffered up should be
+		// written out. Implementing this is optional; by default it does
+		// nothing.
+		virtual void flush() {}
 	};
 
-	// Default reporter writes complete test log to stdout and errors/summary to stderr
+	// Default reporter writes complete test log to stdout and errors/summary to
+	// stderr. The summary includes the given number of slowest tests.
 	struct Default_Reporter : Reporter {
-		Default_Reporter();
+		Default_Reporter(size_t slowest_tests = 10);
 		virtual ~Default_Reporter();
 		virtual void report_test_count   (size_t);
 		virtual void report_test_started (const Test_Info &);
 		virtual void report_test_complete(const Test_Info &);
 		virtual void report_test_error   (const Test_Info &, const Error_Info &);
 		virtual void report_test_summary (const Test_Statistics &);
+		virtual void report_benchmark_result(const Test_Info &, const Benchmark_Result &);
+		virtual void flush();
+		private:
+		size_t                 slowest_count;
+		std::vector<Test_Info> slowest;
 	};
 
 	// TAP reporter writes Test Anything Protocol format to stdout
@@ -516,90 +1044,887 @@ namespace scutl {
 		virtual void report_test_complete(const Test_Info &);
 		virtual void report_test_error   (const Test_Info &, const Error_Info &);
 		virtual void report_test_summary (const Test_Statistics &);
+		virtual void report_benchmark_result(const Test_Info &, const Benchmark_Result &);
+		virtual void flush();
 		private:
 		size_t number;
+		std::vector<Benchmark_Result> benchmarks;
+	};
+
+	// JSON reporter writes one JSON object per line (JSON Lines) to stdout
+	struct JSON_Reporter : Reporter {
+		JSON_Reporter();
+		virtual ~JSON_Reporter();
+		virtual void report_test_count   (size_t);
+		virtual void report_test_started (const Test_Info &);
+		virtual void report_test_complete(const Test_Info &);
+		virtual void report_test_error   (const Test_Info &, const Error_Info &);
+		virtual void report_test_summary (const Test_Statistics &);
+		virtual void report_benchmark_result(const Test_Info &, const Benchmark_Result &);
+		virtual void flush();
+		private:
+		void begin_line(const char *event);
+		void begin_line(const char *event, const Test_Info &);
+		void end_line();
+		std::string buffer;
+	};
+
+	// Asynchronous reporter passes events on to another reporter from a
+	// background thread. Events must not be reported concurrently, which
+	// scutl::run never does. Each Test_Info reported must keep its name,
+	// file and line, and stay alive, until the summary or a flush; the
+	// tests of scutl::run always do.
+	struct Async_Reporter : Reporter {
+		explicit Async_Reporter(Reporter &reporter);
+		virtual ~Async_Reporter();
+		virtual void report_test_count   (size_t);
+		virtual void report_test_started (const Test_Info &);
+		virtual void report_test_complete(const Test_Info &);
+		virtual void report_test_error   (const Test_Info &, const Error_Info &);
+		virtual void report_test_summary (const Test_Statistics &);
+		virtual void report_benchmark_result(const Test_Info &, const Benchmark_Result &);
+		virtual void flush();
+		private:
+		Async_Reporter(const Async_Reporter &);
+		Async_Reporter &operator=(const Async_Reporter &);
+		struct Event;
+		struct Queue;
+		Queue *queue;
+	};
+
+	// Options controlling how scutl::run runs the registered tests.
+	struct Run_Options {
+		Run_Options() :
+			jobs(1), isolate(false), timeout(0),
+			benchmark_time(0.1), benchmark_repetitions(10),
+			shard(1), shards(1), fail_fast(false), repeat(1), list(false),
+			max_errors(0), fail_on_leaks(false)
+		{}
+		size_t      jobs;                  // Workers to run tests on; 0 means one per core
+		bool        isolate;               // Run tests in worker processes instead of threads
+		double      timeout;               // Seconds before an isolated test is killed; 0 is never
+		double      benchmark_time;        // Target seconds for each benchmark repetition
+		size_t      benchmark_repetitions; // Timed repetitions of each benchmark
+		std::string timing_cache;          // File to schedule from and save durations to
+
+		std::vector<std::string> include;       // Name globs to run; empty runs all
+		std::vector<std::string> exclude;       // Name globs to skip
+		std::vector<std::string> include_files; // File globs to run; empty runs all
+		std::vector<std::string> exclude_files; // File globs to skip
+		size_t shard;                           // Which shard to run, from 1 to shards
+		size_t shards;                          // Number of shards the tests are split into
+		bool   fail_fast;                       // Stop after the first failing test
+		size_t repeat;                          // Times to run each selected test
+		bool   list;                            // Print the selected tests instead of running
+		size_t max_errors;                      // Non-fatal errors reported per test; 0 is unlimited
+		bool   fail_on_leaks;                   // Fail tests that leak tracked allocations
 	};
 
+	// Run all registered tests against the given reporter, optionally with
+	// the given options. Returns true if everything passed.
+	bool run(Reporter &reporter);
+	bool run(Reporter &reporter, const Run_Options &options);
+
+	// Set run options from command line arguments, as used by the main
+	// implementation. Returns -1 if the tests should then be run, or else
+	// an exit status, after printing help or an error message.
+	int parse_arguments(int argc, char **argv, Run_Options &options);
+
+	// Tell the running benchmark how much work one iteration of its body
+	// does, so that throughput can be reported along with the timing.
+	void set_items_per_iteration(size_t items);
+	void set_bytes_per_iteration(size_t bytes);
+
+	// Prevent the compiler from optimizing away the computation of a value
+	// in a benchmark, even though the value is never used.
+	template <typename T>
+	inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		const volatile char *bytes = reinterpret_cast<const volatile char *>(&value);
+		(void)*bytes;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+	}
+
+	// Prevent the compiler from assuming memory is unchanged across this
+	// point in a benchmark, forcing pending writes to actually happen.
+	inline void clobber_memory() {
+#if defined(__GNUC__)
+		asm volatile("" : : : "memory");
+#else
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+	}
+
 };
 
 // This namespace is for implementation details only.
 namespace scutl { namespace detail {
 
-	// Base class to encapsulate tests. They are auto-registered in the global
-	// list upon construction.
+	// Storage for fixtures, which isn't counted among the allocations made
+	// by a test, although anything the fixture allocates itself is.
+	void *allocate_fixture(size_t size, size_t alignment);
+	void free_fixture(void *storage, size_t alignment);
+
+	// How to create and destroy the shared fixture of a suite of tests.
+	struct Suite {
+		void *(*create)();
+		void  (*destroy)(void *);
+	};
+
+	// The one suite for each suite fixture class. It only holds constant
+	// data, so it's ready before any test is registered.
+	template <typename Type>
+	struct Suite_Of {
+		static void *create() {
+			void *storage = allocate_fixture(sizeof(Type), alignof(Type));
+			try {
+				return new (storage) Type;
+			} catch (...) {
+				free_fixture(storage, alignof(Type));
+				throw;
+			}
+		}
+		static void destroy(void *fixture) {
+			static_cast<Type *>(fixture)->~Type();
+			free_fixture(fixture, alignof(Type));
+		}
+		static const Suite instance;
+	};
+
+	template <typename Type>
+	const Suite Suite_Of<Type>::instance = { &Suite_Of<Type>::create, &Suite_Of<Type>::destroy };
+
+	// Get the shared fixture of a suite, creating it first if necessary. If
+	// it couldn't be created, the current test fails and is aborted.
+	const void *suite_fixture(const Suite &suite, const char *file, size_t line);
+
+	// Registration of a test, created by TEST_METHOD and friends at static
+	// initialization time. Registrations are auto-registered in the global
+	// list upon construction. The list is intrusive, so registering a test
+	// allocates nothing, and its head and tail are constant-initialized, so
+	// registering is safe no matter what order files are initialized in.
+	struct Registration {
+		Registration(
+			const char  *test_name,
+			const char  *test_file,
+			size_t       test_line,
+			void       (*test_function)(),
+			const Suite *test_suite
+		) :
+			name(test_name), file(test_file), line(test_line),
+			function(test_function), suite(test_suite), next(nullptr)
+		{
+			*last = this;
+			last  = &next;
+		}
+
+		const char   *name;       // From TEST(name)
+		const char   *file;       // Filename from __FILE__
+		size_t        line;       // Line from __LINE__
+		void        (*function)(); // Runs the test
+		const Suite  *suite;      // Suite from TEST_SUITE_METHOD, or null
+		Registration *next;       // Next test in the global list
+
+		// Global test list
+		static Registration  *first;
+		static Registration **last;
+	};
+
+	// A registered test, along with its results, while tests are being run.
 	struct Test {
-		Test() { list().push_back(this); }
-		virtual ~Test() {}
-		virtual void operator()() = 0;
+		Test(const Registration &test_registration) : registration(&test_registration), completed(false) {
+			info.name     = test_registration.name;
+			info.file     = test_registration.file;
+			info.line     = test_registration.line;
+			// We assume that we have passed until we see a failure
+			info.passed   = true;
+			// We assume that we have been aborted until we complete
+			info.aborted  = true;
+			info.duration = 0;
+			info.allocations = Allocation_Info();
+		}
+		void operator()() { registration->function(); }
+
+		// Test registration
+		const Registration *registration;
 
 		// Test information
 		Test_Info info;
 
-		// Global test list
-		typedef std::list<Test *> List;
-		static List &list();
+		// The test has been run and reported in the current repetition
+		bool completed;
+	};
+
+	// Owns a heap-allocated fixture for the duration of a test. Fixtures are
+	// kept off the stack, since they may be large.
+	template <typename Function>
+	struct Fixture {
+		Fixture() : storage(allocate_fixture(sizeof(Function), alignof(Function))) {
+			try {
+				pointer = new (storage) Function;
+			} catch (...) {
+				free_fixture(storage, alignof(Function));
+				throw;
+			}
+		}
+		~Fixture() {
+			pointer->~Function();
+			free_fixture(storage, alignof(Function));
+		}
+		void     *storage;
+		Function *pointer;
+		private:
+		Fixture(const Fixture &);
+		Fixture &operator=(const Fixture &);
 	};
 
 	// Define an empty class used to implement TEST in terms of TEST_METHOD
 	struct Empty_Fixture {};
 
-	// Global pointers set by the test runner and use by assertions
-	struct Global {
-		Test     *test;
-		Reporter *reporter;
+	// Report a failed assertion, aborting the test if it was required.
+	void fail(bool required, const char *expression, const char *file, size_t line);
+
+	// Result of checking a range for a range assertion.
+	struct Range_Comparison {
+		Range_Comparison() :
+			lhs_size(0), rhs_size(0), mismatches(0), first(0), single(false) {}
+		bool failed() const { return mismatches != 0 || lhs_size != rhs_size; }
+		size_t      lhs_size;   // Elements in the (first) range
+		size_t      rhs_size;   // Elements in the second range
+		size_t      mismatches; // Elements that failed the check
+		size_t      first;      // Index of the first element that failed
+		std::string lhs;        // Value at the first failure
+		std::string rhs;        // Value it was compared to, if any
+		bool        single;     // Only one range was checked
 	};
-	extern Global global;
 
-}}
+	// Report a failed range assertion, aborting the test if it was required.
+	void fail_range(bool required, const char *assertion, const char *file, size_t line, const Range_Comparison &);
+
+	// Counts the allocations made by the body of an allocation assertion,
+	// and checks them against the limit once the body is done.
+	struct Allocation_Scope {
+		Allocation_Scope(size_t max_allocations, const char *text, bool is_required, const char *source_file, size_t source_line);
+
+		// True the first time, to run the body, and false the second time,
+		// after checking the allocations it made.
+		bool next();
+
+		size_t      limit;
+		const char *assertion;
+		bool        required;
+		const char *file;
+		size_t      line;
+		size_t      count;
+		size_t      bytes;
+		bool        done;
+	};
 
-// If a specific reporter is requested, this implies that the main
-// implementation is desired as well.
-#ifdef SCUTL_REPORTER
-#ifndef SCUTL_MAIN
-#define SCUTL_MAIN
-#endif
-#endif
+	// Describe values captured by range assertions. Anything that isn't a
+	// number is just described generically, since doing better would need
+	// <sstream> in every file that uses scutl.
+	std::string describe_signed(long long);
+	std::string describe_unsigned(unsigned long long);
+	std::string describe_floating(long double);
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, std::string>::type
+	describe(const T &value) { return describe_signed(value); }
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, std::string>::type
+	describe(const T &value) { return describe_unsigned(value); }
+
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value, std::string>::type
+	describe(const T &value) { return describe_floating(value); }
+
+	template <typename T>
+	typename std::enable_if<std::is_enum<T>::value, std::string>::type
+	describe(const T &value) { return describe_signed(static_cast<long long>(value)); }
+
+	template <typename T>
+	typename std::enable_if<!std::is_arithmetic<T>::value && !std::is_enum<T>::value, std::string>::type
+	describe(const T &) { return "(value)"; }
+
+	// Element checks used by the range assertions.
+	struct Equal {
+		template <typename A, typename B>
+		bool operator()(const A &a, const B &b) const { return a == b; }
+	};
 
-// If the main implementation is requested, we need to add the library
-// implementation as well.
-#ifdef SCUTL_MAIN
-#ifndef SCUTL_LIBRARY
-#define SCUTL_LIBRARY
-#endif
-#endif
+	template <typename Tolerance>
+	struct Near {
+		template <typename A, typename B>
+		bool operator()(const A &a, const B &b) const {
+			return (a < b ? b - a : a - b) <= tolerance;
+		}
+		Tolerance tolerance;
+	};
 
-// Implement the scutl library when requested
-#ifdef SCUTL_LIBRARY
-namespace scutl { namespace detail {
+	template <typename Tolerance>
+	Near<Tolerance> make_near(Tolerance tolerance) {
+		Near<Tolerance> near = { tolerance };
+		return near;
+	}
+
+	// Ranges with their elements stored contiguously are viewed as a Span,
+	// which lets them be checked with simple indexed loops the compiler can
+	// vectorize. Other ranges are walked with their iterators.
+	template <typename T>
+	struct Span {
+		const T *data;
+		size_t   size;
+	};
 
-	// Implement our list of tests. We use a function to return a single
-	// instance instead of a straight global variable to avoid static-
-	// initialization ordering issues.
-	Test::List &Test::list() {
-		static Test::List list;
-		return list;
+	struct Not_Contiguous {};
+
+	struct Any_Range {};
+	struct Contiguous_Range : Any_Range {};
+
+	template <typename T, size_t N>
+	Span<T> span(const T (&range)[N], Contiguous_Range) {
+		Span<T> span = { range, N };
+		return span;
 	}
 
-	// Implement our global structure used to by the runner and assertions.
-	Global global;
+	template <typename Range>
+	auto span(const Range &range, Contiguous_Range) -> Span<
+		typename std::remove_cv<typename std::remove_pointer<decltype(range.data())>::type>::type
+	> {
+		typedef typename std::remove_cv<typename std::remove_pointer<decltype(range.data())>::type>::type T;
+		Span<T> span = { range.data(), size_t(range.size()) };
+		return span;
+	}
 
-	// Helper function to run a single test with a given reporter.
-	void run_test(Test &test, Reporter &reporter, Test_Statistics &statistics) {
+	template <typename Range>
+	Not_Contiguous span(const Range &, Any_Range) {
+		return Not_Contiguous();
+	}
 
-		// Set the global test and reporter pointers for use by assertions.
-		global.test     = &test;
-		global.reporter = &reporter;
+	// Elements of the same type that compare equal exactly when their bytes
+	// do can be checked for equality with memcmp before looking closer.
+	template <typename A, typename B, typename Check>
+	struct Bitwise_Comparable {
+		static const bool value =
+			std::is_same<A, B>::value &&
+			std::is_same<Check, Equal>::value &&
+			(std::is_integral<A>::value || std::is_enum<A>::value || std::is_pointer<A>::value);
+	};
 
-		// Report the test to the reporter.
-		reporter.report_test_started(test.info);
-		++statistics.started;
+	template <typename A, typename B, typename Check>
+	typename std::enable_if<Bitwise_Comparable<A, B, Check>::value, bool>::type
+	bitwise_equal(const Span<A> &a, const Span<B> &b) {
+		return a.size == b.size && (a.size == 0 || std::memcmp(a.data, b.data, a.size * sizeof(A)) == 0);
+	}
 
-		// Run the test inside a try block. If we catch any exceptions,
-		// report them as implicit failed assertions.
-		try {
-			test();
-			// By default test assume they will be aborted. If we don't get
-			// an exception, then we can be assured that didn't happen.
+	template <typename A, typename B, typename Check>
+	typename std::enable_if<!Bitwise_Comparable<A, B, Check>::value, bool>::type
+	bitwise_equal(const Span<A> &, const Span<B> &) {
+		return false;
+	}
+
+	template <typename A, typename B, typename Check>
+	Range_Comparison compare_ranges(Span<A> a, Span<B> b, Check check) {
+		Range_Comparison comparison;
+		comparison.lhs_size = a.size;
+		comparison.rhs_size = b.size;
+		if (bitwise_equal<A, B, Check>(a, b)) return comparison;
+		size_t size = a.size < b.size ? a.size : b.size;
+		size_t mismatches = 0;
+		size_t first      = size;
+		for (size_t i = 0; i < size; ++i) {
+			bool failed = !check(a.data[i], b.data[i]);
+			if (failed && mismatches == 0) first = i;
+			mismatches += failed;
+		}
+		comparison.mismatches = mismatches;
+		if (mismatches == 0) return comparison;
+		comparison.first = first;
+		comparison.lhs   = describe(a.data[first]);
+		comparison.rhs   = describe(b.data[first]);
+		return comparison;
+	}
+
+	template <typename A, typename B, typename Check, typename Span_A, typename Span_B>
+	Range_Comparison compare_ranges(const A &a, const B &b, Check check, Span_A, Span_B) {
+		Range_Comparison comparison;
+		auto i = std::begin(a);
+		auto j = std::begin(b);
+		for (; i != std::end(a) && j != std::end(b); ++i, ++j, ++comparison.lhs_size) {
+			if (check(*i, *j)) continue;
+			if (comparison.mismatches++ == 0) {
+				comparison.first = comparison.lhs_size;
+				comparison.lhs   = describe(*i);
+				comparison.rhs   = describe(*j);
+			}
+		}
+		comparison.rhs_size = comparison.lhs_size;
+		for (; i != std::end(a); ++i) ++comparison.lhs_size;
+		for (; j != std::end(b); ++j) ++comparison.rhs_size;
+		return comparison;
+	}
+
+	template <typename A, typename B, typename Check, typename T, typename U>
+	Range_Comparison compare_ranges(const A &, const B &, Check check, Span<T> a, Span<U> b) {
+		return compare_ranges(a, b, check);
+	}
+
+	template <typename A, typename B, typename Check>
+	Range_Comparison compare_ranges(const A &a, const B &b, Check check) {
+		return compare_ranges(a, b, check, span(a, Contiguous_Range()), span(b, Contiguous_Range()));
+	}
+
+	template <typename T, typename Predicate>
+	Range_Comparison check_range(Span<T> a, Predicate &predicate) {
+		Range_Comparison comparison;
+		comparison.single   = true;
+		comparison.lhs_size = a.size;
+		comparison.rhs_size = a.size;
+		size_t mismatches = 0;
+		size_t first      = a.size;
+		for (size_t i = 0; i < a.size; ++i) {
+			bool failed = !predicate(a.data[i]);
+			if (failed && mismatches == 0) first = i;
+			mismatches += failed;
+		}
+		comparison.mismatches = mismatches;
+		if (mismatches == 0) return comparison;
+		comparison.first = first;
+		comparison.lhs   = describe(a.data[first]);
+		return comparison;
+	}
+
+	template <typename Range, typename Predicate>
+	Range_Comparison check_range(const Range &range, Predicate &predicate, Not_Contiguous) {
+		Range_Comparison comparison;
+		comparison.single = true;
+		for (auto i = std::begin(range); i != std::end(range); ++i, ++comparison.lhs_size) {
+			if (predicate(*i)) continue;
+			if (comparison.mismatches++ == 0) {
+				comparison.first = comparison.lhs_size;
+				comparison.lhs   = describe(*i);
+			}
+		}
+		comparison.rhs_size = comparison.lhs_size;
+		return comparison;
+	}
+
+	template <typename Range, typename Predicate, typename T>
+	Range_Comparison check_range(const Range &, Predicate &predicate, Span<T> a) {
+		return check_range(a, predicate);
+	}
+
+	template <typename Range, typename Predicate>
+	Range_Comparison check_range(const Range &range, Predicate predicate) {
+		return check_range(range, predicate, span(range, Contiguous_Range()));
+	}
+
+	// Global pointers set by the test runner and use by assertions. Each
+	// thread running tests has its own copy.
+	struct Global {
+		Test     *test;
+		Reporter *reporter;
+		size_t    items;      // Items per benchmark iteration
+		size_t    bytes;      // Bytes per benchmark iteration
+		size_t    errors;     // Errors reported by the current test
+		size_t    suppressed; // Errors not reported because of max_errors
+
+		// Allocation tracking for the current test.
+		bool   tracking;        // Allocations are currently being counted
+		size_t epoch;           // Identifies allocations made by this test
+		size_t allocations;     // Allocations made
+		size_t allocated_bytes; // Bytes allocated in total
+		size_t live_bytes;      // Bytes allocated and not yet freed
+		size_t peak_bytes;      // Most live bytes so far
+	};
+	extern thread_local Global global;
+
+	// Options of the current run, for use by benchmarks.
+	extern Run_Options options;
+
+	// Runners used by the TEST_METHOD and BENCHMARK_METHOD macros.
+	template <typename Function>
+	inline void call(Function &function) {
+		function();
+	}
+
+	void benchmark(void (*iterate)(void *, size_t), void *function);
+
+	template <typename Function>
+	void iterate(void *function, size_t iterations) {
+		Function &body = *static_cast<Function *>(function);
+		for (size_t i = 0; i < iterations; ++i) {
+			body();
+		}
+	}
+
+	template <typename Function>
+	inline void benchmark(Function &function) {
+		benchmark(&iterate<Function>, &function);
+	}
+
+}}
+
+// If a specific reporter is requested, this implies that the main
+// implementation is desired as well.
+#ifdef SCUTL_REPORTER
+#ifndef SCUTL_MAIN
+#define SCUTL_MAIN
+#endif
+#endif
+
+// If the main implementation is requested, we need to add the library
+// implementation as well.
+#ifdef SCUTL_MAIN
+#ifndef SCUTL_LIBRARY
+#define SCUTL_LIBRARY
+#endif
+#endif
+
+// Implement the scutl library when requested
+#ifdef SCUTL_LIBRARY
+
+// Standard library headers needed only by the implementation
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// Process isolation needs fork and friends, which only POSIX systems have.
+#if defined(__unix__) || defined(__APPLE__)
+#define SCUTL_DETAIL_FORK
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace scutl { namespace detail {
+
+	// Implement our list of tests. Both pointers are constant-initialized,
+	// so they are valid before any test registers itself.
+	Registration  *Registration::first = nullptr;
+	Registration **Registration::last  = &Registration::first;
+
+	// Implement our global structure used to by the runner and assertions.
+	thread_local Global global;
+
+	// Implement our copy of the current run options.
+	Run_Options options;
+
+	// Whether operator new and delete count allocations in this executable.
+#ifdef SCUTL_ALLOCATIONS
+	const bool allocations_tracked = true;
+#else
+	const bool allocations_tracked = false;
+#endif
+
+	// Source of the epochs that tell which test made an allocation.
+	std::atomic<size_t> allocation_epochs(0);
+
+	// Turns allocation tracking on or off for the current thread while in
+	// scope. Scutl turns it off while reporting, so that a test's counts
+	// only include its own allocations.
+	struct Tracking {
+		Tracking(bool on) : was(global.tracking) {
+			global.tracking = on && allocations_tracked;
+		}
+		~Tracking() {
+			global.tracking = was;
+		}
+		bool was;
+	};
+
+	// Over-aligned fixtures get extra room to be aligned within, with the
+	// address actually allocated stored just before the fixture.
+	void *allocate_fixture(size_t size, size_t alignment) {
+		Tracking tracking(false);
+		if (alignment <= alignof(std::max_align_t)) return ::operator new(size);
+		char *block = static_cast<char *>(::operator new(size + alignment + sizeof(void *)));
+		uintptr_t address = reinterpret_cast<uintptr_t>(block + sizeof(void *));
+		address = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+		void **storage = reinterpret_cast<void **>(address);
+		storage[-1] = block;
+		return storage;
+	}
+
+	void free_fixture(void *storage, size_t alignment) {
+		if (alignment <= alignof(std::max_align_t)) {
+			::operator delete(storage);
+		} else {
+			::operator delete(static_cast<void **>(storage)[-1]);
+		}
+	}
+
+	// Start a fresh count of allocations for a test on the current thread.
+	void reset_allocations() {
+		global.epoch           = ++allocation_epochs;
+		global.allocations     = 0;
+		global.allocated_bytes = 0;
+		global.live_bytes      = 0;
+		global.peak_bytes      = 0;
+	}
+
+	Allocation_Scope::Allocation_Scope(size_t max_allocations, const char *text, bool is_required, const char *source_file, size_t source_line) :
+		limit(max_allocations),
+		assertion(text),
+		required(is_required),
+		file(source_file),
+		line(source_line),
+		count(global.allocations),
+		bytes(global.allocated_bytes),
+		done(false)
+	{}
+
+	bool Allocation_Scope::next() {
+		if (!done) {
+			done = true;
+			return true;
+		}
+		if (!global.tracking) {
+			std::string expression = assertion;
+			expression += allocations_tracked
+				? ": allocations are only tracked on the thread running the test"
+				: ": allocations are not tracked; define SCUTL_ALLOCATIONS";
+			fail(required, expression.c_str(), file, line);
+			return false;
+		}
+		size_t made = global.allocations - count;
+		if (made > limit) {
+			Tracking tracking(false);
+			std::string expression = assertion;
+			expression += ": made " + describe_unsigned(made) + " allocations";
+			expression += " of " + describe_unsigned(global.allocated_bytes - bytes) + " bytes";
+			fail(required, expression.c_str(), file, line);
+		}
+		return false;
+	}
+
+	// Report an error in the current test, unless it has already reported
+	// as many as the run options allow.
+	void report_error(const Error_Info &error_info) {
+		Tracking tracking(false);
+		if (!error_info.required && options.max_errors != 0 && global.errors >= options.max_errors) {
+			++global.suppressed;
+			return;
+		}
+		++global.errors;
+		global.reporter->report_test_error(global.test->info, error_info);
+	}
+
+	// Report a failed assertion from EXPECT or REQUIRE.
+	void fail(bool required, const char *expression, const char *file, size_t line) {
+		Tracking tracking(false);
+
+		// Collect information about the assertion.
+		Error_Info error_info;
+		error_info.required   = required;
+		error_info.expression = expression;
+		error_info.file       = file;
+		error_info.line       = line;
+
+		// Mark current test as failed
+		global.test->info.passed = false;
+
+		// Report results
+		report_error(error_info);
+
+		// Throw the error information as an exception to abort the test if
+		// this was a required assertion.
+		if (required) {
+			// Mark current test as aborted
+			global.test->info.aborted = true;
+			throw error_info;
+		}
+	}
+
+	// Report a failed range assertion, with the values that caused it.
+	void fail_range(bool required, const char *assertion, const char *file, size_t line, const Range_Comparison &comparison) {
+		Tracking tracking(false);
+		std::string expression = assertion;
+		expression += ": ";
+		if (comparison.lhs_size != comparison.rhs_size) {
+			expression += "sizes differ, " + describe_unsigned(comparison.lhs_size);
+			expression += " != " + describe_unsigned(comparison.rhs_size);
+			if (comparison.mismatches != 0) expression += ", and ";
+		}
+		if (comparison.mismatches != 0) {
+			size_t size = comparison.lhs_size < comparison.rhs_size ? comparison.lhs_size : comparison.rhs_size;
+			expression += describe_unsigned(comparison.mismatches) + " of " + describe_unsigned(size);
+			expression += comparison.single ? " elements fail" : " elements differ";
+			expression += ", first at [" + describe_unsigned(comparison.first) + "]: " + comparison.lhs;
+			if (!comparison.single) expression += " != " + comparison.rhs;
+		}
+		fail(required, expression.c_str(), file, line);
+	}
+
+	std::string describe_signed(long long value) {
+		char buffer[32];
+		std::snprintf(buffer, sizeof buffer, "%lld", value);
+		return buffer;
+	}
+
+	std::string describe_unsigned(unsigned long long value) {
+		char buffer[32];
+		std::snprintf(buffer, sizeof buffer, "%llu", value);
+		return buffer;
+	}
+
+	std::string describe_floating(long double value) {
+		char buffer[64];
+		std::snprintf(buffer, sizeof buffer, "%.17Lg", value);
+		return buffer;
+	}
+
+	// The state of a suite's shared fixture during a run.
+	struct Suite_State {
+		Suite_State() : fixture(nullptr), failed(false), remaining(0) {}
+		std::mutex  mutex;     // Held while creating or destroying the fixture
+		void       *fixture;   // The fixture, once created
+		bool        failed;    // Creating the fixture failed
+		std::string error;     // Why creating the fixture failed
+		size_t      remaining; // Runs of the suite's tests still to come
+	};
+
+	// Every suite used during the current run.
+	std::mutex                           suites_mutex;
+	std::map<const Suite *, Suite_State> suites;
+
+	Suite_State &suite_state(const Suite &suite) {
+		std::lock_guard<std::mutex> lock(suites_mutex);
+		return suites[&suite];
+	}
+
+	const void *suite_fixture(const Suite &suite, const char *file, size_t line) {
+
+		// Only the suite's own tests are counted towards tearing it down, so
+		// any other test could find the fixture gone, or recreate and leak it.
+		if (global.test->registration->suite != &suite) {
+			fail(true, "SUITE_FIXTURE used by a test outside of its suite", file, line);
+		}
+
+		Suite_State &state = suite_state(suite);
+		std::string error;
+		Error_Info failure;
+		bool reported = false;
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+
+			// Try to create the fixture only once, even if it fails, since
+			// it's presumably expensive. The fixture belongs to the suite, so
+			// its allocations aren't counted against the current test.
+			if (!state.fixture && !state.failed) {
+				Tracking tracking(false);
+				try {
+					state.fixture = suite.create();
+				} catch (const Error_Info &error_info) {
+					state.error = error_info.expression;
+					failure  = error_info;
+					reported = true;
+				} catch (const std::exception &e) {
+					state.error = std::string("unexpected exception: ") + e.what();
+				} catch (...) {
+					state.error = "unknown exception";
+				}
+				state.failed = !state.fixture;
+			}
+			if (state.fixture) return state.fixture;
+			error = state.error;
+		}
+
+		// A failed assertion in the fixture's constructor has already been
+		// reported against this test. Every other test that needs the
+		// fixture fails the same way.
+		if (reported) throw failure;
+		error = "suite fixture setup failed: " + error;
+		fail(true, error.c_str(), file, line);
+		return nullptr;
+	}
+
+	// Destroy a suite fixture. Its allocations belong to the suite, not to
+	// whichever test happens to run last.
+	void destroy_suite_fixture(const Suite &suite, void *fixture) {
+		Tracking tracking(false);
+		suite.destroy(fixture);
+	}
+
+	// Count a test as run for its suite, destroying the suite's fixture
+	// once the suite has no more tests to run.
+	void finish_suite(const Suite &suite) {
+		Suite_State &state = suite_state(suite);
+		std::lock_guard<std::mutex> lock(state.mutex);
+		if (state.remaining == 0 || --state.remaining != 0) return;
+		if (state.fixture) destroy_suite_fixture(suite, state.fixture);
+		state.fixture = nullptr;
+		state.failed  = false;
+	}
+
+	// Destroy any suite fixtures still around at the end of a run, such as
+	// when failing fast, and forget about the suites.
+	void destroy_suites() {
+		std::lock_guard<std::mutex> lock(suites_mutex);
+		for (std::map<const Suite *, Suite_State>::iterator i = suites.begin(); i != suites.end(); ++i) {
+			if (i->second.fixture) destroy_suite_fixture(*i->first, i->second.fixture);
+		}
+		suites.clear();
+	}
+
+	// Helper function to report a test as started.
+	void start_test(Test &test, Reporter &reporter, Test_Statistics &statistics) {
+		reporter.report_test_started(test.info);
+		++statistics.started;
+	}
+
+	// Helper function to run the body of a single test, reporting any errors
+	// it has to the given reporter.
+	void execute_test(Test &test, Reporter &reporter) {
+
+		// Set the global test and reporter pointers for use by assertions.
+		global.test     = &test;
+		global.reporter = &reporter;
+		global.items      = 0;
+		global.bytes      = 0;
+		global.errors     = 0;
+		global.suppressed = 0;
+		reset_allocations();
+
+		// Time the test, including construction and destruction of any
+		// fixture, but not the reporting that happens around it.
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point start = Clock::now();
+
+		// Run the test inside a try block. If we catch any exceptions,
+		// report them as implicit failed assertions.
+		try {
+			Tracking tracking(true);
+			// Tests in a suite all need its fixture, so make sure it exists
+			// first; if it can't be created, this is where that's reported.
+			if (test.registration->suite) {
+				suite_fixture(*test.registration->suite, test.info.file.c_str(), test.info.line);
+			}
+			test();
+			// By default test assume they will be aborted. If we don't get
+			// an exception, then we can be assured that didn't happen.
 			test.info.aborted = false;
 		} catch (const Error_Info &) {
 			// If an Error_Info is received as an exception, we know it
@@ -607,28 +1932,1120 @@ namespace scutl { namespace detail {
 			// handling is unnecessary here.
 		} catch (const std::exception &e) {
 			Error_Info error_info;
+			error_info.required   = true;
 			error_info.expression = std::string("unexpected exception: ") + e.what();
 			error_info.file = test.info.file;
 			error_info.line = test.info.line;
 			test.info.passed  = false;
 			test.info.aborted = true;
-			reporter.report_test_error(test.info, error_info);
+			report_error(error_info);
 		} catch (...) {
 			Error_Info error_info;
+			error_info.required   = true;
 			error_info.expression = "unknown exception";
 			error_info.file = test.info.file;
 			error_info.line = test.info.line;
 			test.info.passed  = false;
 			test.info.aborted = true;
+			report_error(error_info);
+		}
+
+		Clock::time_point end = Clock::now();
+
+		// Tear down the suite fixture after the last test that uses it.
+		// This isn't counted in the test's duration, since it's shared.
+		if (test.registration->suite) finish_suite(*test.registration->suite);
+
+		// Anything the test allocated and hasn't freed by now, after its
+		// fixture and any exception it threw are gone, has leaked.
+		test.info.allocations.tracked      = allocations_tracked;
+		test.info.allocations.count        = global.allocations;
+		test.info.allocations.bytes        = global.allocated_bytes;
+		test.info.allocations.peak_bytes   = global.peak_bytes;
+		test.info.allocations.leaked_bytes = global.live_bytes;
+		if (options.fail_on_leaks && global.live_bytes != 0) {
+			Error_Info error_info;
+			error_info.required   = false;
+			error_info.expression = "leaked " + describe_unsigned(global.live_bytes) + " bytes";
+			error_info.file = test.info.file;
+			error_info.line = test.info.line;
+			test.info.passed = false;
+			reporter.report_test_error(test.info, error_info);
+		}
+
+		// Let the reporter know how many errors weren't shown.
+		if (global.suppressed != 0) {
+			Error_Info error_info;
+			error_info.required   = false;
+			error_info.expression = describe_unsigned(global.suppressed) + " more errors suppressed";
+			error_info.file = test.info.file;
+			error_info.line = test.info.line;
 			reporter.report_test_error(test.info, error_info);
 		}
+		test.info.duration = std::chrono::duration<double>(end - start).count();
+	}
 
-		// Report the test completion
+	// Helper function to report a test as complete.
+	void complete_test(Test &test, Reporter &reporter, Test_Statistics &statistics) {
+		test.completed = true;
 		reporter.report_test_complete(test.info);
 		++statistics.complete;
 		if (test.info.passed)  ++statistics.passed; else ++statistics.failed;
 		if (test.info.aborted) ++statistics.aborted;
 	}
+
+	// Helper function to run a single test with a given reporter.
+	void run_test(Test &test, Reporter &reporter, Test_Statistics &statistics) {
+		start_test(test, reporter, statistics);
+		execute_test(test, reporter);
+		complete_test(test, reporter, statistics);
+	}
+
+	// Helper function to time the given number of iterations of a benchmark
+	// body, returning the elapsed time in seconds.
+	double time_iterations(void (*iterate)(void *, size_t), void *function, size_t iterations) {
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point start = Clock::now();
+		iterate(function, iterations);
+		Clock::time_point end = Clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	// Run a benchmark body and report how long it takes. The fixture has
+	// already been constructed, so only the body itself is timed. First the
+	// number of iterations is calibrated so that each repetition takes about
+	// the requested time, then one untimed warmup repetition is run before
+	// the timed repetitions that the statistics come from. A benchmark whose
+	// body fails an assertion is stopped after that pass, so the failure
+	// isn't repeated for every iteration, and produces no result.
+	void benchmark(void (*iterate)(void *, size_t), void *function) {
+		const Test_Info &info = global.test->info;
+
+		// Double the iterations until a run takes a measurable fraction of
+		// the target time, then scale them up to fill the target.
+		double target = options.benchmark_time;
+		size_t iterations = 1;
+		double elapsed = time_iterations(iterate, function, iterations);
+		if (!info.passed) return;
+		while (elapsed < target / 10 && iterations < (size_t(1) << 40)) {
+			iterations *= 2;
+			elapsed = time_iterations(iterate, function, iterations);
+			if (!info.passed) return;
+		}
+		if (elapsed > 0 && elapsed < target) {
+			iterations = size_t(iterations * (target / elapsed));
+		}
+		if (iterations < 1) iterations = 1;
+
+		// Warm up, then collect the per-iteration time of each repetition.
+		time_iterations(iterate, function, iterations);
+		if (!info.passed) return;
+		size_t repetitions = options.benchmark_repetitions;
+		if (repetitions < 1) repetitions = 1;
+		std::vector<double> samples;
+		for (size_t i = 0; i < repetitions; ++i) {
+			samples.push_back(time_iterations(iterate, function, iterations) / iterations);
+			if (!info.passed) return;
+		}
+
+		// Summarize the samples.
+		Benchmark_Result result;
+		result.iterations  = iterations;
+		result.repetitions = repetitions;
+		std::sort(samples.begin(), samples.end());
+		double sum = 0;
+		for (size_t i = 0; i < samples.size(); ++i) sum += samples[i];
+		result.mean = sum / samples.size();
+		double squares = 0;
+		for (size_t i = 0; i < samples.size(); ++i) {
+			squares += (samples[i] - result.mean) * (samples[i] - result.mean);
+		}
+		result.stddev = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0;
+		size_t middle = samples.size() / 2;
+		result.median = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+		result.min = samples.front();
+		result.max = samples.back();
+		result.items_per_second = result.mean > 0 ? global.items / result.mean : 0;
+		result.bytes_per_second = result.mean > 0 ? global.bytes / result.mean : 0;
+
+		Tracking tracking(false);
+		global.reporter->report_benchmark_result(global.test->info, result);
+	}
+
+	// Helper function to format a time in seconds with a readable unit.
+	std::string format_seconds(double seconds) {
+		static const char *units[] = { "s", "ms", "us", "ns" };
+		size_t unit = 0;
+		while (unit < 3 && seconds != 0 && std::fabs(seconds) < 1) {
+			seconds *= 1000;
+			++unit;
+		}
+		std::ostringstream ss;
+		ss << std::setprecision(3) << seconds << units[unit];
+		return ss.str();
+	}
+
+	// Helper function to format a per-second rate with a metric prefix.
+	std::string format_rate(double rate, const char *unit) {
+		static const char *prefixes[] = { "", "k", "M", "G", "T" };
+		size_t prefix = 0;
+		while (prefix < 4 && rate >= 1000) {
+			rate /= 1000;
+			++prefix;
+		}
+		std::ostringstream ss;
+		ss << std::setprecision(3) << rate << prefixes[prefix] << unit << "/s";
+		return ss.str();
+	}
+
+	// Reporter used to hold on to the errors of a single test until it is
+	// that test's turn to be reported for real.
+	struct Recording_Reporter : Reporter {
+		Recording_Reporter() : done(false) {}
+		virtual void report_test_count   (size_t) {}
+		virtual void report_test_started (const Test_Info &) {}
+		virtual void report_test_complete(const Test_Info &) {}
+		virtual void report_test_error   (const Test_Info &, const Error_Info &error_info) {
+			errors.push_back(error_info);
+		}
+		virtual void report_test_summary (const Test_Statistics &) {}
+		virtual void report_benchmark_result(const Test_Info &, const Benchmark_Result &result) {
+			benchmarks.push_back(result);
+		}
+		std::vector<Error_Info>       errors;
+		std::vector<Benchmark_Result> benchmarks;
+		bool done;
+	};
+
+	// Collects the results of tests that finish out of order and passes them
+	// to the real reporter strictly in list order, so the reporter sees
+	// exactly the same calls as it would in a serial run.
+	struct Ordered_Results {
+
+		Ordered_Results(
+			std::vector<Test *> &run_tests,
+			Reporter            &run_reporter,
+			Test_Statistics     &run_statistics,
+			bool                 stop_on_failure
+		) :
+			tests(run_tests),
+			reporter(run_reporter),
+			statistics(run_statistics),
+			results(run_tests.size()),
+			next(0),
+			fail_fast(stop_on_failure),
+			stopped(false)
+		{}
+
+		// The recorder to use while running the test with the given index.
+		Recording_Reporter &recorder(size_t index) {
+			return results[index];
+		}
+
+		// Mark a test as finished, then report every test that is now ready
+		// to be reported in order. When failing fast, nothing after the first
+		// failure is reported, just as if the tests had been run serially,
+		// and workers should stop taking new tests.
+		void finish(size_t index) {
+			std::lock_guard<std::mutex> lock(mutex);
+			results[index].done = true;
+			while (!stopped && next < tests.size() && results[next].done) {
+				Test &test = *tests[next];
+				std::vector<Error_Info> &errors = results[next].errors;
+				std::vector<Benchmark_Result> &benchmarks = results[next].benchmarks;
+				start_test(test, reporter, statistics);
+				for (size_t i = 0; i < errors.size(); ++i) {
+					reporter.report_test_error(test.info, errors[i]);
+				}
+				for (size_t i = 0; i < benchmarks.size(); ++i) {
+					reporter.report_benchmark_result(test.info, benchmarks[i]);
+				}
+				complete_test(test, reporter, statistics);
+				++next;
+				if (fail_fast && !test.info.passed) stopped = true;
+			}
+		}
+
+		std::vector<Test *>             &tests;
+		Reporter                        &reporter;
+		Test_Statistics                 &statistics;
+		std::vector<Recording_Reporter>  results;
+		std::mutex                       mutex;
+		size_t                           next;
+		bool                             fail_fast;
+		std::atomic<bool>                stopped;
+	};
+
+	// Runs a list of tests on several worker threads. Each worker owns a
+	// queue of units of work: a single test, or all the tests of a suite,
+	// which are run one after another. It takes work from the front of its
+	// own queue and steals from the back of the others when its own runs out.
+	struct Parallel_Runner {
+
+		typedef std::vector<size_t> Unit;
+
+		struct Queue {
+			std::mutex       mutex;
+			std::deque<Unit> units;
+		};
+
+		Parallel_Runner(
+			std::vector<Test *>       &run_tests,
+			const std::vector<size_t> &schedule,
+			Reporter                  &reporter,
+			Test_Statistics           &statistics,
+			size_t                     jobs,
+			bool                       fail_fast
+		) :
+			tests(run_tests),
+			queues(jobs),
+			results(run_tests, reporter, statistics, fail_fast)
+		{
+			// Deal units out round-robin in schedule order, so that each
+			// worker starts with its share of the longest tests.
+			size_t units = 0;
+			for (size_t i = 0; i < schedule.size(); ++i) {
+				const Suite *suite = tests[schedule[i]]->registration->suite;
+				if (i == 0 || !suite || tests[schedule[i - 1]]->registration->suite != suite) {
+					queues[units++ % jobs].units.push_back(Unit());
+				}
+				queues[(units - 1) % jobs].units.back().push_back(schedule[i]);
+			}
+		}
+
+		// Run all the tests, using the calling thread as the first worker.
+		void operator()() {
+			std::vector<std::thread> threads;
+			for (size_t worker = 1; worker < queues.size(); ++worker) {
+				threads.push_back(std::thread(&Parallel_Runner::work, this, worker));
+			}
+			work(0);
+			for (size_t i = 0; i < threads.size(); ++i) {
+				threads[i].join();
+			}
+		}
+
+		// Take the next unit for the given worker, stealing if needed.
+		// Returns false once every queue is empty, or the run has stopped.
+		bool take(size_t worker, Unit &unit) {
+			if (results.stopped) return false;
+			{
+				Queue &own = queues[worker];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.units.empty()) {
+					unit.swap(own.units.front());
+					own.units.pop_front();
+					return true;
+				}
+			}
+			for (size_t offset = 1; offset < queues.size(); ++offset) {
+				Queue &victim = queues[(worker + offset) % queues.size()];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (!victim.units.empty()) {
+					unit.swap(victim.units.back());
+					victim.units.pop_back();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Worker loop: run tests until there is nothing left to take.
+		void work(size_t worker) {
+			Unit unit;
+			while (take(worker, unit)) {
+				for (size_t i = 0; i < unit.size() && !results.stopped; ++i) {
+					execute_test(*tests[unit[i]], results.recorder(unit[i]));
+					results.finish(unit[i]);
+				}
+			}
+		}
+
+		std::vector<Test *> &tests;
+		std::vector<Queue>   queues;
+		Ordered_Results      results;
+	};
+
+#ifdef SCUTL_DETAIL_FORK
+
+	// Helper function to write an entire buffer to a file descriptor.
+	// Returns false if the other end has gone away.
+	bool write_all(int fd, const char *data, size_t size) {
+		while (size > 0) {
+			ssize_t written = ::write(fd, data, size);
+			if (written < 0 && errno == EINTR) continue;
+			if (written <= 0) return false;
+			data += written;
+			size -= written;
+		}
+		return true;
+	}
+
+	// Helper function to read an entire buffer from a file descriptor.
+	// Returns false on end of file or error.
+	bool read_all(int fd, char *data, size_t size) {
+		while (size > 0) {
+			ssize_t count = ::read(fd, data, size);
+			if (count < 0 && errno == EINTR) continue;
+			if (count <= 0) return false;
+			data += count;
+			size -= count;
+		}
+		return true;
+	}
+
+	// Messages sent between the parent and its worker processes are a
+	// sequence of fields prefixed by their total length. Numbers are sent in
+	// native byte order, since both ends are always the same program.
+	struct Message {
+		void put(uint64_t value) {
+			data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+		}
+		void put(double value) {
+			data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+		}
+		void put(const std::string &value) {
+			put(uint64_t(value.size()));
+			data.append(value);
+		}
+		bool send(int fd) const {
+			uint64_t size = data.size();
+			std::string framed(reinterpret_cast<const char *>(&size), sizeof(size));
+			framed.append(data);
+			return write_all(fd, framed.data(), framed.size());
+		}
+		bool get(uint64_t &value) {
+			if (data.size() - position < sizeof(value)) return false;
+			std::memcpy(&value, data.data() + position, sizeof(value));
+			position += sizeof(value);
+			return true;
+		}
+		bool get(double &value) {
+			if (data.size() - position < sizeof(value)) return false;
+			std::memcpy(&value, data.data() + position, sizeof(value));
+			position += sizeof(value);
+			return true;
+		}
+		bool get(std::string &value) {
+			uint64_t size;
+			if (!get(size) || data.size() - position < size) return false;
+			value.assign(data, position, size);
+			position += size;
+			return true;
+		}
+		Message() : position(0) {}
+		std::string data;
+		size_t      position;
+	};
+
+	// Reporter used inside a worker process. It forwards each event to the
+	// parent as soon as it happens, so nothing is lost if the test crashes.
+	struct Pipe_Reporter : Reporter {
+		enum Kind { started, error, complete, benchmark };
+		Pipe_Reporter(int output) : fd(output), index(0) {}
+		virtual void report_test_count(size_t) {}
+		virtual void report_test_started(const Test_Info &) {
+			Message message;
+			message.put(uint64_t(started));
+			message.put(uint64_t(index));
+			message.send(fd);
+		}
+		virtual void report_test_complete(const Test_Info &test_info) {
+			Message message;
+			message.put(uint64_t(complete));
+			message.put(uint64_t(index));
+			message.put(uint64_t(test_info.passed));
+			message.put(uint64_t(test_info.aborted));
+			message.put(test_info.duration);
+			message.put(uint64_t(test_info.allocations.tracked));
+			message.put(uint64_t(test_info.allocations.count));
+			message.put(uint64_t(test_info.allocations.bytes));
+			message.put(uint64_t(test_info.allocations.peak_bytes));
+			message.put(uint64_t(test_info.allocations.leaked_bytes));
+			message.send(fd);
+		}
+		virtual void report_test_error(const Test_Info &, const Error_Info &error_info) {
+			Message message;
+			message.put(uint64_t(error));
+			message.put(uint64_t(index));
+			message.put(uint64_t(error_info.required));
+			message.put(error_info.expression);
+			message.put(error_info.file);
+			message.put(uint64_t(error_info.line));
+			message.send(fd);
+		}
+		virtual void report_test_summary(const Test_Statistics &) {}
+		virtual void report_benchmark_result(const Test_Info &, const Benchmark_Result &result) {
+			Message message;
+			message.put(uint64_t(benchmark));
+			message.put(uint64_t(index));
+			message.put(uint64_t(result.iterations));
+			message.put(uint64_t(result.repetitions));
+			message.put(result.mean);
+			message.put(result.median);
+			message.put(result.stddev);
+			message.put(result.min);
+			message.put(result.max);
+			message.put(result.items_per_second);
+			message.put(result.bytes_per_second);
+			message.send(fd);
+		}
+		int    fd;
+		size_t index;
+	};
+
+	// Name of a signal that killed a worker, for use in error reports.
+	std::string signal_name(int signal) {
+		switch (signal) {
+			case SIGABRT: return "SIGABRT";
+			case SIGBUS:  return "SIGBUS";
+			case SIGFPE:  return "SIGFPE";
+			case SIGILL:  return "SIGILL";
+			case SIGINT:  return "SIGINT";
+			case SIGKILL: return "SIGKILL";
+			case SIGPIPE: return "SIGPIPE";
+			case SIGSEGV: return "SIGSEGV";
+			case SIGTERM: return "SIGTERM";
+			case SIGTRAP: return "SIGTRAP";
+		}
+		std::ostringstream ss;
+		ss << "signal " << signal;
+		return ss.str();
+	}
+
+	// Runs a list of tests in a pool of forked worker processes, so that a
+	// test that crashes or hangs can only take its own worker down with it.
+	// Workers are handed batches of tests over a pipe and send back each
+	// reporter event over another. The parent enforces the per-test timeout,
+	// reports crashed and timed out tests as aborted failures, and starts a
+	// replacement worker whenever one dies.
+	struct Isolated_Runner {
+
+		typedef std::chrono::steady_clock Clock;
+
+		struct Worker {
+			Worker() : pid(-1), input(-1), output(-1), current(none) {}
+			pid_t              pid;     // Process id, or -1 if not running
+			int                input;   // Parent writes batches here
+			int                output;  // Parent reads events from here
+			std::deque<size_t> batch;   // Sent but not yet started
+			size_t             current; // Started but not yet complete
+			Clock::time_point  started; // When current was started
+			std::string        buffer;  // Partially received events
+		};
+
+		static const size_t none = size_t(-1);
+
+		Isolated_Runner(
+			std::vector<Test *>       &run_tests,
+			const std::vector<size_t> &schedule,
+			Reporter                  &reporter,
+			Test_Statistics           &statistics,
+			size_t                     jobs,
+			double                     test_timeout,
+			bool                       fail_fast
+		) :
+			tests(run_tests),
+			workers(jobs),
+			pending(schedule.begin(), schedule.end()),
+			results(run_tests, reporter, statistics, fail_fast),
+			timeout(test_timeout),
+			sigpipe_handler(SIG_DFL)
+		{}
+
+		// Run all the tests, returning once every one has been reported.
+		void operator()() {
+			// A worker dying while we write to it must not kill us as well.
+			sigpipe_handler = ::signal(SIGPIPE, SIG_IGN);
+			while (busy() || !pending.empty()) {
+				if (results.stopped) {
+					// Failing fast: nothing else will be reported, so
+					// there's no point waiting for the workers to finish.
+					pending.clear();
+					for (size_t i = 0; i < workers.size(); ++i) {
+						if (workers[i].pid >= 0) reap(workers[i], true);
+					}
+					break;
+				}
+				for (size_t i = 0; i < workers.size(); ++i) {
+					if (workers[i].pid < 0) dispatch(workers[i]);
+				}
+				wait();
+				collect(false);
+			}
+			collect(true);
+			::signal(SIGPIPE, sigpipe_handler);
+		}
+
+		// True while any worker still has tests it hasn't finished.
+		bool busy() const {
+			for (size_t i = 0; i < workers.size(); ++i) {
+				if (workers[i].pid >= 0) return true;
+			}
+			return false;
+		}
+
+		// Start a worker process. Anything buffered for stdout/stderr is
+		// flushed first so that the child doesn't write it a second time.
+		void spawn(Worker &worker) {
+			int to_child[2], from_child[2];
+			if (::pipe(to_child) != 0) return;
+			if (::pipe(from_child) != 0) {
+				::close(to_child[0]);
+				::close(to_child[1]);
+				return;
+			}
+			std::cout.flush();
+			std::cerr.flush();
+			std::fflush(nullptr);
+			pid_t pid = ::fork();
+			if (pid == 0) {
+				::close(to_child[1]);
+				::close(from_child[0]);
+				for (size_t i = 0; i < workers.size(); ++i) {
+					if (workers[i].pid < 0) continue;
+					::close(workers[i].input);
+					::close(workers[i].output);
+				}
+				// Tests should run with the same signal handling as usual.
+				::signal(SIGPIPE, sigpipe_handler);
+				serve(to_child[0], from_child[1]);
+				destroy_suites();
+				std::cout.flush();
+				std::cerr.flush();
+				std::fflush(nullptr);
+				::_exit(0);
+			}
+			::close(to_child[0]);
+			::close(from_child[1]);
+			if (pid < 0) {
+				::close(to_child[1]);
+				::close(from_child[0]);
+				return;
+			}
+			worker.pid    = pid;
+			worker.input  = to_child[1];
+			worker.output = from_child[0];
+			worker.buffer.clear();
+		}
+
+		// Body of a worker process: run each batch of tests we are sent,
+		// until we are sent an empty batch or the parent goes away.
+		void serve(int input, int output) {
+			Pipe_Reporter reporter(output);
+			Test_Statistics statistics = Test_Statistics();
+			for (;;) {
+				uint64_t count;
+				if (!read_all(input, reinterpret_cast<char *>(&count), sizeof(count))) return;
+				if (count == 0) return;
+				std::vector<uint64_t> batch(count);
+				if (!read_all(input, reinterpret_cast<char *>(&batch[0]), count * sizeof(uint64_t))) return;
+				for (size_t i = 0; i < batch.size(); ++i) {
+					reporter.index = batch[i];
+					run_test(*tests[batch[i]], reporter, statistics);
+					std::cout.flush();
+				}
+			}
+		}
+
+		// Give a worker its next batch of tests, starting it if necessary,
+		// or tell it to exit if there is nothing left to do. Batches shrink
+		// as the run nears its end so the work stays evenly spread, but
+		// never split up the tests of a suite.
+		void dispatch(Worker &worker) {
+			if (pending.empty()) {
+				if (worker.pid >= 0) retire(worker);
+				return;
+			}
+			if (worker.pid < 0) spawn(worker);
+			if (worker.pid < 0) {
+				// We couldn't start a worker, so there's no way to isolate
+				// this test. Report that instead of running it unprotected.
+				size_t index = pending.front();
+				pending.pop_front();
+				fail(index, "unable to start a worker process");
+				return;
+			}
+			size_t size = pending.size() / (workers.size() * 4);
+			if (size < 1)  size = 1;
+			if (size > 64) size = 64;
+			std::vector<uint64_t> batch;
+			while (!pending.empty() && (batch.size() < size || same_suite(batch.back(), pending.front()))) {
+				worker.batch.push_back(pending.front());
+				batch.push_back(pending.front());
+				pending.pop_front();
+			}
+			uint64_t count = batch.size();
+			if (
+				!write_all(worker.input, reinterpret_cast<const char *>(&count), sizeof(count)) ||
+				!write_all(worker.input, reinterpret_cast<const char *>(&batch[0]), count * sizeof(uint64_t))
+			) {
+				// The worker is already gone; we'll find out why when we
+				// next wait for events.
+			}
+		}
+
+		// True if both tests belong to the same suite.
+		bool same_suite(size_t a, size_t b) const {
+			const Suite *suite = tests[a]->registration->suite;
+			return suite && tests[b]->registration->suite == suite;
+		}
+
+		// Tell a worker to exit cleanly. It may still be tearing down suite
+		// fixtures, so rather than waiting for it here, it's collected later.
+		void retire(Worker &worker) {
+			uint64_t count = 0;
+			write_all(worker.input, reinterpret_cast<const char *>(&count), sizeof(count));
+			::close(worker.input);
+			::close(worker.output);
+			retired.push_back(worker.pid);
+			worker.pid = -1;
+		}
+
+		// Collect the exit status of retired workers, waiting for them all
+		// to exit if asked to, or otherwise only those that already have.
+		void collect(bool block) {
+			for (size_t i = 0; i < retired.size();) {
+				pid_t result;
+				while ((result = ::waitpid(retired[i], nullptr, block ? 0 : WNOHANG)) < 0 && errno == EINTR) {}
+				if (result == 0) {
+					++i;
+				} else {
+					retired.erase(retired.begin() + i);
+				}
+			}
+		}
+
+		// Close down a worker that has exited (or that we are about to kill)
+		// and collect its exit status. Returns a description of how it died.
+		std::string reap(Worker &worker, bool kill) {
+			if (kill) ::kill(worker.pid, SIGKILL);
+			::close(worker.input);
+			::close(worker.output);
+			int status = 0;
+			while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+			worker.pid = -1;
+			std::ostringstream ss;
+			if (WIFSIGNALED(status)) {
+				ss << "crashed with signal " << signal_name(WTERMSIG(status));
+			} else {
+				ss << "exited unexpectedly with status " << WEXITSTATUS(status);
+			}
+			return ss.str();
+		}
+
+		// Record a test as an aborted failure with the given reason.
+		void fail(size_t index, const std::string &reason) {
+			Test &test = *tests[index];
+			Error_Info error_info;
+			error_info.required   = true;
+			error_info.expression = reason;
+			error_info.file       = test.info.file;
+			error_info.line       = test.info.line;
+			results.recorder(index).errors.push_back(error_info);
+			test.info.passed  = false;
+			test.info.aborted = true;
+			results.finish(index);
+		}
+
+		// Handle a worker that died or was killed with tests outstanding.
+		// The test that was running is failed; tests in its batch that never
+		// started are put back to be given to another worker.
+		void lost(Worker &worker, const std::string &reason) {
+			if (worker.current != none) {
+				Test &test = *tests[worker.current];
+				test.info.duration = std::chrono::duration<double>(Clock::now() - worker.started).count();
+				fail(worker.current, reason);
+				worker.current = none;
+			}
+			while (!worker.batch.empty()) {
+				pending.push_front(worker.batch.back());
+				worker.batch.pop_back();
+			}
+			dispatch(worker);
+		}
+
+		// Handle a single event received from a worker.
+		void receive(Worker &worker, Message &message) {
+			uint64_t kind, index;
+			if (!message.get(kind) || !message.get(index)) return;
+			Test &test = *tests[index];
+			if (kind == Pipe_Reporter::started) {
+				if (!worker.batch.empty()) worker.batch.pop_front();
+				worker.current = index;
+				worker.started = Clock::now();
+			} else if (kind == Pipe_Reporter::error) {
+				Error_Info error_info;
+				uint64_t required = 0, line = 0;
+				message.get(required);
+				message.get(error_info.expression);
+				message.get(error_info.file);
+				message.get(line);
+				error_info.required = required != 0;
+				error_info.line     = line;
+				results.recorder(index).errors.push_back(error_info);
+			} else if (kind == Pipe_Reporter::benchmark) {
+				Benchmark_Result result = Benchmark_Result();
+				uint64_t iterations = 0, repetitions = 0;
+				message.get(iterations);
+				message.get(repetitions);
+				message.get(result.mean);
+				message.get(result.median);
+				message.get(result.stddev);
+				message.get(result.min);
+				message.get(result.max);
+				message.get(result.items_per_second);
+				message.get(result.bytes_per_second);
+				result.iterations  = iterations;
+				result.repetitions = repetitions;
+				results.recorder(index).benchmarks.push_back(result);
+			} else if (kind == Pipe_Reporter::complete) {
+				uint64_t passed = 0, aborted = 1;
+				message.get(passed);
+				message.get(aborted);
+				message.get(test.info.duration);
+				uint64_t tracked = 0, count = 0, bytes = 0, peak_bytes = 0, leaked_bytes = 0;
+				message.get(tracked);
+				message.get(count);
+				message.get(bytes);
+				message.get(peak_bytes);
+				message.get(leaked_bytes);
+				test.info.passed  = passed != 0;
+				test.info.aborted = aborted != 0;
+				test.info.allocations.tracked      = tracked != 0;
+				test.info.allocations.count        = count;
+				test.info.allocations.bytes        = bytes;
+				test.info.allocations.peak_bytes   = peak_bytes;
+				test.info.allocations.leaked_bytes = leaked_bytes;
+				worker.current = none;
+				results.finish(index);
+				if (worker.batch.empty()) dispatch(worker);
+			}
+		}
+
+		// Wait for events from any worker, handling whatever arrives and any
+		// worker that dies or runs out of time in the meantime.
+		void wait() {
+			std::vector<pollfd> fds;
+			std::vector<Worker *> polled;
+			int wait_ms = -1;
+			Clock::time_point now = Clock::now();
+			for (size_t i = 0; i < workers.size(); ++i) {
+				Worker &worker = workers[i];
+				if (worker.pid < 0) continue;
+				pollfd fd;
+				fd.fd      = worker.output;
+				fd.events  = POLLIN;
+				fd.revents = 0;
+				fds.push_back(fd);
+				polled.push_back(&worker);
+				if (timeout > 0 && worker.current != none) {
+					double left = timeout - std::chrono::duration<double>(now - worker.started).count();
+					int left_ms =
+						left <= 0                ? 0 :
+						left >= INT_MAX / 1000.0 ? INT_MAX :
+						int(left * 1000) + 1;
+					if (wait_ms < 0 || left_ms < wait_ms) wait_ms = left_ms;
+				}
+			}
+			if (fds.empty()) return;
+			if (::poll(&fds[0], fds.size(), wait_ms) < 0 && errno != EINTR) return;
+
+			now = Clock::now();
+			for (size_t i = 0; i < fds.size(); ++i) {
+				Worker &worker = *polled[i];
+				if (fds[i].revents != 0) {
+					char data[4096];
+					ssize_t count = ::read(worker.output, data, sizeof(data));
+					if (count < 0 && errno == EINTR) continue;
+					if (count <= 0) {
+						lost(worker, reap(worker, false));
+						continue;
+					}
+					worker.buffer.append(data, count);
+					size_t used = 0;
+					for (;;) {
+						uint64_t size;
+						if (worker.buffer.size() - used < sizeof(size)) break;
+						std::memcpy(&size, worker.buffer.data() + used, sizeof(size));
+						if (worker.buffer.size() - used - sizeof(size) < size) break;
+						Message message;
+						message.data.assign(worker.buffer, used + sizeof(size), size);
+						used += sizeof(size) + size;
+						receive(worker, message);
+					}
+					worker.buffer.erase(0, used);
+				} else if (
+					timeout > 0 && worker.current != none &&
+					std::chrono::duration<double>(now - worker.started).count() >= timeout
+				) {
+					reap(worker, true);
+					std::ostringstream ss;
+					ss << "timed out after " << timeout << " seconds";
+					lost(worker, ss.str());
+				}
+			}
+		}
+
+		std::vector<Test *> &tests;
+		std::vector<Worker>  workers;
+		std::vector<pid_t>   retired;
+		std::deque<size_t>   pending;
+		Ordered_Results      results;
+		double               timeout;
+		void               (*sigpipe_handler)(int);
+	};
+
+#endif // SCUTL_DETAIL_FORK
+
+	// Durations of tests from earlier runs, keyed by file and name. Line
+	// numbers are left out of the key so that editing a file doesn't throw
+	// away its timings. Tests sharing a name share the longest duration.
+	typedef std::map<std::string, double> Timings;
+
+	// Helper function to make the timing cache key for a test.
+	std::string timing_key(const Test &test) {
+		return test.info.file + "\t" + test.info.name;
+	}
+
+	// Read the timing cache file, if there is one. Each line has the
+	// duration in seconds, the file, and the name, separated by tabs.
+	Timings read_timings(const std::string &path) {
+		Timings timings;
+		std::ifstream file(path.c_str());
+		std::string line;
+		while (std::getline(file, line)) {
+			size_t tab = line.find('\t');
+			if (tab == std::string::npos) continue;
+			double duration = std::strtod(line.c_str(), nullptr);
+			double &entry = timings[line.substr(tab + 1)];
+			entry = std::max(entry, duration);
+		}
+		return timings;
+	}
+
+	// Save the durations of the tests just run to the timing cache file,
+	// keeping the entries of any tests that weren't part of this run, or
+	// that didn't get to complete, say because the run stopped early.
+	void write_timings(const std::string &path, Timings timings, const std::vector<Test *> &tests) {
+		Timings current;
+		for (size_t i = 0; i < tests.size(); ++i) {
+			if (!tests[i]->completed) continue;
+			double &entry = current[timing_key(*tests[i])];
+			entry = std::max(entry, tests[i]->info.duration);
+		}
+		for (Timings::iterator i = current.begin(); i != current.end(); ++i) {
+			timings[i->first] = i->second;
+		}
+		std::ofstream file(path.c_str());
+		file << std::setprecision(6);
+		for (Timings::iterator i = timings.begin(); i != timings.end(); ++i) {
+			file << i->second << "\t" << i->first << "\n";
+		}
+	}
+
+	// Decide the order in which tests are handed to workers: longest first,
+	// according to the given timings, so that a long test isn't left to
+	// start last and hold up the end of the run. Tests with no recorded
+	// timing might be long, so they go first of all. Ties keep list order.
+	// The tests of a suite, already grouped together, are scheduled as one
+	// unit by their total time, so that they stay together.
+	struct Longest_First {
+		Longest_First(const std::vector<double> &test_durations) : durations(test_durations) {}
+		bool operator()(size_t a, size_t b) const {
+			return durations[a] > durations[b];
+		}
+		const std::vector<double> &durations;
+	};
+
+	std::vector<size_t> schedule(const std::vector<Test *> &tests, const Timings &timings) {
+		std::vector<size_t> units;
+		std::vector<double> durations(tests.size());
+		for (size_t i = 0; i < tests.size(); ++i) {
+			const Suite *suite = tests[i]->registration->suite;
+			if (!suite || i == 0 || tests[i - 1]->registration->suite != suite) {
+				units.push_back(i);
+			}
+			Timings::const_iterator entry = timings.find(timing_key(*tests[i]));
+			durations[units.back()] += entry == timings.end() ? HUGE_VAL : entry->second;
+		}
+		if (!timings.empty()) {
+			std::stable_sort(units.begin(), units.end(), Longest_First(durations));
+		}
+		std::vector<size_t> order;
+		for (size_t unit = 0; unit < units.size(); ++unit) {
+			size_t i = units[unit];
+			const Suite *suite = tests[i]->registration->suite;
+			do {
+				order.push_back(i++);
+			} while (suite && i < tests.size() && tests[i]->registration->suite == suite);
+		}
+		return order;
+	}
+
+	// Match text against a glob pattern, where '*' matches any run of
+	// characters and '?' matches any single character.
+	bool glob_match(const char *pattern, const char *text) {
+		const char *star_pattern = nullptr;
+		const char *star_text    = nullptr;
+		while (*text) {
+			if (*pattern == '*') {
+				star_pattern = ++pattern;
+				star_text    = text;
+			} else if (*pattern == '?' || *pattern == *text) {
+				++pattern;
+				++text;
+			} else if (star_pattern) {
+				pattern = star_pattern;
+				text    = ++star_text;
+			} else {
+				return false;
+			}
+		}
+		while (*pattern == '*') ++pattern;
+		return *pattern == '\0';
+	}
+
+	// Helper function to check text against a list of glob patterns.
+	bool glob_match_any(const std::vector<std::string> &patterns, const std::string &text) {
+		for (size_t i = 0; i < patterns.size(); ++i) {
+			if (glob_match(patterns[i].c_str(), text.c_str())) return true;
+		}
+		return false;
+	}
+
+	// Stable 64-bit FNV-1a hash, used to assign tests to shards the same way
+	// on every machine.
+	uint64_t hash(const std::string &text) {
+		uint64_t value = 14695981039346656037ULL;
+		for (size_t i = 0; i < text.size(); ++i) {
+			value ^= static_cast<unsigned char>(text[i]);
+			value *= 1099511628211ULL;
+		}
+		return value;
+	}
+
+	// Sort order for balancing shards: longest first, then by hash, so that
+	// every machine makes the same assignments.
+	struct Shard_Order {
+		Shard_Order(const std::vector<double> &test_durations, const std::vector<uint64_t> &test_hashes) :
+			durations(test_durations), hashes(test_hashes) {}
+		bool operator()(size_t a, size_t b) const {
+			if (durations[a] != durations[b]) return durations[a] > durations[b];
+			return hashes[a] < hashes[b];
+		}
+		const std::vector<double>   &durations;
+		const std::vector<uint64_t> &hashes;
+	};
+
+	// Work out which shard each test belongs to. Without timings, tests are
+	// split by hash. With timings, tests that have one are handed out
+	// longest first to whichever shard has the least work so far; tests
+	// without one are still split by hash and counted as average length.
+	std::vector<size_t> assign_shards(const std::vector<Test *> &tests, const Timings &timings, size_t shards) {
+		std::vector<size_t>   assignments(tests.size());
+		std::vector<double>   durations(tests.size());
+		std::vector<uint64_t> hashes(tests.size());
+		std::vector<double>   loads(shards);
+		std::vector<size_t>   known;
+		double total = 0;
+		for (size_t i = 0; i < tests.size(); ++i) {
+			hashes[i] = hash(timing_key(*tests[i]));
+			Timings::const_iterator entry = timings.find(timing_key(*tests[i]));
+			if (entry == timings.end()) {
+				durations[i] = -1;
+			} else {
+				durations[i] = entry->second;
+				total += entry->second;
+				known.push_back(i);
+			}
+		}
+		double average = known.empty() ? 0 : total / known.size();
+		for (size_t i = 0; i < tests.size(); ++i) {
+			if (durations[i] >= 0) continue;
+			assignments[i] = hashes[i] % shards;
+			loads[assignments[i]] += average;
+		}
+		std::sort(known.begin(), known.end(), Shard_Order(durations, hashes));
+		for (size_t i = 0; i < known.size(); ++i) {
+			size_t lightest = 0;
+			for (size_t shard = 1; shard < shards; ++shard) {
+				if (loads[shard] < loads[lightest]) lightest = shard;
+			}
+			assignments[known[i]] = lightest;
+			loads[lightest] += durations[known[i]];
+		}
+		return assignments;
+	}
+
+	// Pick out the tests selected by the filters and shard in the options.
+	std::vector<Test *> select_tests(const std::vector<Test *> &tests, const Run_Options &run_options, const Timings &timings) {
+		std::vector<Test *> selected;
+		for (size_t i = 0; i < tests.size(); ++i) {
+			const Test_Info &info = tests[i]->info;
+			if (!run_options.include.empty() && !glob_match_any(run_options.include, info.name)) continue;
+			if (!run_options.include_files.empty() && !glob_match_any(run_options.include_files, info.file)) continue;
+			if (glob_match_any(run_options.exclude, info.name)) continue;
+			if (glob_match_any(run_options.exclude_files, info.file)) continue;
+			selected.push_back(tests[i]);
+		}
+		if (run_options.shards <= 1) return selected;
+		std::vector<size_t> assignments = assign_shards(selected, timings, run_options.shards);
+		std::vector<Test *> shard;
+		for (size_t i = 0; i < selected.size(); ++i) {
+			if (assignments[i] + 1 == run_options.shard) shard.push_back(selected[i]);
+		}
+		return shard;
+	}
+
+	// Move the tests of each suite up to follow its first test, so that the
+	// suite's shared fixture is torn down as soon as possible. Otherwise,
+	// tests keep their order.
+	std::vector<Test *> group_suites(const std::vector<Test *> &tests) {
+		std::map<const Suite *, std::vector<Test *> > members;
+		for (size_t i = 0; i < tests.size(); ++i) {
+			const Suite *suite = tests[i]->registration->suite;
+			if (suite) members[suite].push_back(tests[i]);
+		}
+		std::vector<Test *> grouped;
+		for (size_t i = 0; i < tests.size(); ++i) {
+			const Suite *suite = tests[i]->registration->suite;
+			if (!suite) {
+				grouped.push_back(tests[i]);
+				continue;
+			}
+			std::vector<Test *> &suite_tests = members[suite];
+			grouped.insert(grouped.end(), suite_tests.begin(), suite_tests.end());
+			suite_tests.clear();
+		}
+		return grouped;
+	}
+
+	// Count how many times each suite's tests will be run, so that the last
+	// of them can tear the suite's fixture down.
+	void prepare_suites(const std::vector<Test *> &tests, size_t repeat) {
+		std::lock_guard<std::mutex> lock(suites_mutex);
+		for (size_t i = 0; i < tests.size(); ++i) {
+			const Suite *suite = tests[i]->registration->suite;
+			if (suite) suites[suite].remaining += repeat;
+		}
+	}
+
+	// Put a test back into its initial state so it can be run again.
+	void reset_test(Test &test) {
+		test.info.passed   = true;
+		test.info.aborted  = true;
+		test.info.duration = 0;
+		test.info.allocations = Allocation_Info();
+		test.completed = false;
+	}
+
+	// Helper function to parse a whole number from an argument.
+	bool parse_count(const std::string &text, size_t &value) {
+		if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+		value = std::strtoul(text.c_str(), nullptr, 10);
+		return true;
+	}
 }}
 
 namespace scutl {
@@ -637,6 +3054,14 @@ namespace scutl {
 	// run all the registered tests against the given reporter. Returns true
 	// if everything passed, otherwise false.
 	bool run(Reporter &reporter) {
+		return run(reporter, Run_Options());
+	}
+
+	// As above, but using the given options to control the run.
+	bool run(Reporter &reporter, const Run_Options &options) {
+
+		// Make the options available to benchmarks
+		scutl::detail::options = options;
 
 		// Zero out statistics we will be collecting while running
 		Test_Statistics statistics;
@@ -646,22 +3071,104 @@ namespace scutl {
 		statistics.passed   = 0;
 		statistics.failed   = 0;
 		statistics.aborted  = 0;
+		statistics.duration = 0;
 
-		// Grab a reference to our test list
-		scutl::detail::Test::List &test_list = scutl::detail::Test::list();
+		// Set up every registered test to be run, and make a list of them
+		// that can be indexed by the workers
+		std::vector<scutl::detail::Test> registered;
+		for (
+			scutl::detail::Registration *registration = scutl::detail::Registration::first;
+			registration;
+			registration = registration->next
+		) {
+			registered.push_back(scutl::detail::Test(*registration));
+		}
+		std::vector<scutl::detail::Test *> tests;
+		for (size_t i = 0; i < registered.size(); ++i) {
+			tests.push_back(&registered[i]);
+		}
+
+		// Pick out the tests to run, and work out the order that workers
+		// will take them in
+		scutl::detail::Timings timings;
+		if (!options.timing_cache.empty()) {
+			timings = scutl::detail::read_timings(options.timing_cache);
+		}
+		tests = scutl::detail::select_tests(tests, options, timings);
+		tests = scutl::detail::group_suites(tests);
+		std::vector<size_t> schedule = scutl::detail::schedule(tests, timings);
+
+		// Just list the tests if that's all that was asked for.
+		if (options.list) {
+			for (size_t i = 0; i < tests.size(); ++i) {
+				const Test_Info &info = tests[i]->info;
+				std::cout << info.file << ":" << info.line << ":" << info.name << "\n";
+			}
+			return true;
+		}
 
 		// Inform the reporter of how many tests we are going to run.
-		statistics.count = test_list.size();
+		size_t repeat = options.repeat < 1 ? 1 : options.repeat;
+		statistics.count = tests.size() * repeat;
 		reporter.report_test_count(statistics.count);
+		scutl::detail::prepare_suites(tests, repeat);
+
+		// Decide how many worker threads to use. There is no point in having
+		// more workers than tests.
+		size_t jobs = options.jobs;
+		if (jobs == 0) jobs = std::thread::hardware_concurrency();
+		if (jobs > tests.size()) jobs = tests.size();
+
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point start = Clock::now();
+
+		for (size_t repetition = 0; repetition < repeat; ++repetition) {
+			for (size_t i = 0; i < tests.size(); ++i) {
+				scutl::detail::reset_test(*tests[i]);
+			}
+
+			if (options.isolate && !tests.empty()) {
+#ifdef SCUTL_DETAIL_FORK
+				// Run the tests in a pool of worker processes.
+				if (jobs < 1) jobs = 1;
+				scutl::detail::Isolated_Runner runner(
+					tests, schedule, reporter, statistics, jobs, options.timeout, options.fail_fast
+				);
+				runner();
+#else
+				// Without fork, the best we can do is run the tests normally.
+				for (size_t i = 0; i < tests.size(); ++i) {
+					scutl::detail::run_test(*tests[i], reporter, statistics);
+					if (options.fail_fast && !tests[i]->info.passed) break;
+				}
+#endif
+			} else if (jobs <= 1) {
+				// Run each test with the given reporter.
+				for (size_t i = 0; i < tests.size(); ++i) {
+					scutl::detail::run_test(*tests[i], reporter, statistics);
+					if (options.fail_fast && !tests[i]->info.passed) break;
+				}
+			} else {
+				// Spread the tests across the worker threads.
+				scutl::detail::Parallel_Runner runner(
+					tests, schedule, reporter, statistics, jobs, options.fail_fast
+				);
+				runner();
+			}
+
+			if (options.fail_fast && statistics.failed > 0) break;
+		}
 
-		// Run each test with the given reporter.
-		for (
-			scutl::detail::Test::List::iterator test_iterator = test_list.begin();
-			test_iterator != test_list.end();
-			++test_iterator
-		) {
-			scutl::detail::Test &test = **test_iterator;
-			scutl::detail::run_test(test, reporter, statistics);
+		Clock::time_point end = Clock::now();
+		statistics.duration = std::chrono::duration<double>(end - start).count();
+		scutl::detail::destroy_suites();
+
+		// Remember how long each test took for next time
+		// A sharded run leaves the cache alone: shards are only consistent
+		// if every shard reads the same cache, and each shard would only
+		// update its own tests.
+		if (!options.timing_cache.empty() && options.shards <= 1) {
+			scutl::detail::write_timings(options.timing_cache, timings, tests);
 		}
 
 		// Report the final summary
@@ -675,9 +3182,128 @@ namespace scutl {
 			(statistics.aborted == 0);
 	}
 
+	// Parse the command line for the main implementation.
+	int parse_arguments(int argc, char **argv, Run_Options &options) {
+		const char *usage =
+			"usage: %s [option]... [name-glob]...\n"
+			"\n"
+			"Runs the tests whose names match any of the given globs, or all of\n"
+			"them if none are given. In a glob, '*' matches any run of characters\n"
+			"and '?' matches any single character.\n"
+			"\n"
+			"  --exclude=GLOB       skip tests whose names match GLOB\n"
+			"  --file=GLOB          only run tests in files matching GLOB\n"
+			"  --exclude-file=GLOB  skip tests in files matching GLOB\n"
+			"  --list               list the selected tests instead of running them\n"
+			"  --shard=I/N          run only shard I (from 1 to N) of N\n"
+			"  --fail-fast          stop after the first failing test\n"
+			"  --repeat=N           run each selected test N times\n"
+			"  --max-errors=N       report at most N non-fatal errors per test; 0 is all\n"
+			"  --fail-on-leaks      fail tests that leak allocations they made\n"
+			"  --jobs=N             run tests on N workers; 0 is one per core\n"
+			"  --isolate            run tests in worker processes\n"
+			"  --timeout=SECONDS    kill isolated tests that run longer than this\n"
+			"  --timing-cache=FILE  schedule from and save test durations to FILE;\n"
+			"                       sharded runs only read it\n"
+			"  --help               show this help\n"
+			"\n"
+			"Option values can also be given as the next argument, as in\n"
+			"--exclude GLOB.\n"
+		;
+		const char *valued[] = {
+			"--exclude", "--file", "--exclude-file", "--shard", "--repeat",
+			"--max-errors", "--jobs", "--timeout", "--timing-cache"
+		};
+		for (int i = 1; i < argc; ++i) {
+			int start = i;
+			std::string argument = argv[i];
+			std::string value;
+			bool has_value = false;
+			size_t equals = argument.find('=');
+			if (argument.compare(0, 2, "--") == 0 && equals != std::string::npos) {
+				value = argument.substr(equals + 1);
+				argument.erase(equals);
+				has_value = true;
+			}
+			bool takes_value = false;
+			for (size_t j = 0; j < sizeof valued / sizeof *valued; ++j) {
+				if (argument == valued[j]) takes_value = true;
+			}
+			if (takes_value && !has_value && i + 1 < argc) {
+				value = argv[++i];
+				has_value = true;
+			}
+			// Options either need a value or can't have one.
+			bool valid = takes_value == has_value;
+			if (!valid) {
+				// Reported below.
+			} else if (argument == "--help") {
+				std::printf(usage, argv[0]);
+				return 0;
+			} else if (argument == "--exclude") {
+				options.exclude.push_back(value);
+				valid = !value.empty();
+			} else if (argument == "--file") {
+				options.include_files.push_back(value);
+				valid = !value.empty();
+			} else if (argument == "--exclude-file") {
+				options.exclude_files.push_back(value);
+				valid = !value.empty();
+			} else if (argument == "--list") {
+				options.list = true;
+			} else if (argument == "--shard") {
+				size_t slash = value.find('/');
+				valid =
+					slash != std::string::npos &&
+					detail::parse_count(value.substr(0, slash), options.shard) &&
+					detail::parse_count(value.substr(slash + 1), options.shards) &&
+					options.shard >= 1 && options.shard <= options.shards;
+			} else if (argument == "--fail-fast") {
+				options.fail_fast = true;
+			} else if (argument == "--repeat") {
+				valid = detail::parse_count(value, options.repeat) && options.repeat >= 1;
+			} else if (argument == "--max-errors") {
+				valid = detail::parse_count(value, options.max_errors);
+			} else if (argument == "--fail-on-leaks") {
+				options.fail_on_leaks = true;
+			} else if (argument == "--jobs") {
+				valid = detail::parse_count(value, options.jobs);
+			} else if (argument == "--isolate") {
+				options.isolate = true;
+			} else if (argument == "--timeout") {
+				char *end = nullptr;
+				options.timeout = std::strtod(value.c_str(), &end);
+				valid = !value.empty() && *end == '\0' && options.timeout >= 0;
+			} else if (argument == "--timing-cache") {
+				options.timing_cache = value;
+				valid = !value.empty();
+			} else if (argument.compare(0, 1, "-") == 0) {
+				valid = false;
+			} else {
+				options.include.push_back(argument);
+			}
+			if (!valid) {
+				std::fprintf(stderr, "%s: invalid argument: %s\n\n", argv[0], argv[start]);
+				std::fprintf(stderr, usage, argv[0]);
+				return 2;
+			}
+		}
+		return -1;
+	}
+
+	// Implementation of the benchmark helpers.
+
+	void set_items_per_iteration(size_t items) {
+		detail::global.items = items;
+	}
+
+	void set_bytes_per_iteration(size_t bytes) {
+		detail::global.bytes = bytes;
+	}
+
 	// Implementation of the default reporter.
 
-	Default_Reporter::Default_Reporter() {}
+	Default_Reporter::Default_Reporter(size_t slowest_tests) : slowest_count(slowest_tests) {}
 
 	Default_Reporter::~Default_Reporter() {}
 
@@ -695,6 +3321,19 @@ namespace scutl {
 	}
 
 	void Default_Reporter::report_test_complete(const Test_Info &test_info) {
+		const Allocation_Info &allocations = test_info.allocations;
+		if (allocations.tracked) {
+			std::cout
+				<< "scutl: "
+				<< test_info.file << ":"
+				<< test_info.line << ":"
+				<< test_info.name << ": ALLOCATIONS: "
+				<< allocations.count << " allocations, "
+				<< allocations.bytes << " bytes, "
+				<< allocations.peak_bytes << " bytes peak, "
+				<< allocations.leaked_bytes << " bytes leaked\n"
+			;
+		}
 		std::cout
 			<< "scutl: "
 			<< test_info.file << ":"
@@ -703,6 +3342,14 @@ namespace scutl {
 			<< (test_info.passed ? " passed" : " failed")
 			<< (test_info.aborted ? " (aborted)\n" : "\n")
 		;
+
+		// Keep track of the slowest tests, slowest first.
+		if (slowest_count == 0) return;
+		if (slowest.size() == slowest_count && test_info.duration <= slowest.back().duration) return;
+		std::vector<Test_Info>::iterator position = slowest.begin();
+		while (position != slowest.end() && position->duration >= test_info.duration) ++position;
+		slowest.insert(position, test_info);
+		if (slowest.size() > slowest_count) slowest.pop_back();
 	}
 
 	void Default_Reporter::report_test_error(const Test_Info &test_info, const Error_Info &error_info) {
@@ -718,6 +3365,28 @@ namespace scutl {
 		std::cerr << ss.str();
 	}
 
+	void Default_Reporter::report_benchmark_result(const Test_Info &test_info, const Benchmark_Result &result) {
+		std::cout
+			<< "scutl: "
+			<< test_info.file << ":"
+			<< test_info.line << ":"
+			<< test_info.name << ": BENCHMARK: "
+			<< "mean "    << detail::format_seconds(result.mean)   << ", "
+			<< "median "  << detail::format_seconds(result.median) << ", "
+			<< "stddev "  << detail::format_seconds(result.stddev) << ", "
+			<< "min "     << detail::format_seconds(result.min)    << ", "
+			<< "max "     << detail::format_seconds(result.max)    << " "
+			<< "(" << result.repetitions << " x " << result.iterations << " iterations)"
+		;
+		if (result.items_per_second > 0) {
+			std::cout << ", " << detail::format_rate(result.items_per_second, " items");
+		}
+		if (result.bytes_per_second > 0) {
+			std::cout << ", " << detail::format_rate(result.bytes_per_second, "B");
+		}
+		std::cout << "\n";
+	}
+
 	void Default_Reporter::report_test_summary(const Test_Statistics &statistics) {
 		std::ostringstream ss;
 		ss
@@ -737,11 +3406,27 @@ namespace scutl {
 			<< std::setw(8) << statistics.failed   << "|"
 			<< std::setw(8) << statistics.aborted  << "|"
 			<< "\n"
+			<< "scutl: TIME: "
+			<< detail::format_seconds(statistics.duration) << " total"
+			<< "\n"
 		;
+		for (size_t i = 0; i < slowest.size(); ++i) {
+			ss
+				<< "scutl: SLOWEST: "
+				<< detail::format_seconds(slowest[i].duration) << " "
+				<< slowest[i].file << ":"
+				<< slowest[i].line << ":"
+				<< slowest[i].name << "\n"
+			;
+		}
 		std::cout << ss.str();
 		std::cerr << ss.str();
 	}
 
+	void Default_Reporter::flush() {
+		std::cout.flush();
+	}
+
 	// Implementation of the Test Anything Protocol (TAP) reporter.
 
 	TAP_Reporter::TAP_Reporter() {
@@ -768,6 +3453,29 @@ namespace scutl {
 			<< test_info.line
 			<< (test_info.aborted ? ": aborted\n" : "\n")
 		;
+		// Benchmark results follow the test line as a YAML diagnostic block.
+		for (size_t i = 0; i < benchmarks.size(); ++i) {
+			const Benchmark_Result &result = benchmarks[i];
+			std::cout
+				<< "  ---\n"
+				<< "  benchmark:\n"
+				<< "    iterations: "       << result.iterations       << "\n"
+				<< "    repetitions: "      << result.repetitions      << "\n"
+				<< "    mean: "             << result.mean             << "\n"
+				<< "    median: "           << result.median           << "\n"
+				<< "    stddev: "           << result.stddev           << "\n"
+				<< "    min: "              << result.min              << "\n"
+				<< "    max: "              << result.max              << "\n"
+				<< "    items_per_second: " << result.items_per_second << "\n"
+				<< "    bytes_per_second: " << result.bytes_per_second << "\n"
+				<< "  ...\n"
+			;
+		}
+		benchmarks.clear();
+	}
+
+	void TAP_Reporter::report_benchmark_result(const Test_Info &, const Benchmark_Result &result) {
+		benchmarks.push_back(result);
 	}
 
 	void TAP_Reporter::report_test_error(const Test_Info &test_info, const Error_Info &error_info) {
@@ -781,7 +3489,487 @@ namespace scutl {
 
 	void TAP_Reporter::report_test_summary(const Test_Statistics &) {}
 
+	void TAP_Reporter::flush() {
+		std::cout.flush();
+	}
+
+#ifdef SCUTL_ALLOCATIONS
+	// Allocation tracking, used by the replacement operator new and delete
+	// below. Each block is preceded by a header holding its size and the
+	// epoch of the test that allocated it, if any, so that freeing it can
+	// be counted against the right test.
+	namespace detail {
+
+		const size_t allocation_header =
+			alignof(std::max_align_t) > 2 * sizeof(size_t) ? alignof(std::max_align_t) : 2 * sizeof(size_t);
+
+		void *allocate(size_t size) noexcept {
+			if (size > size_t(-1) - allocation_header) return nullptr;
+			char *block = static_cast<char *>(std::malloc(size + allocation_header));
+			if (!block) return nullptr;
+			size_t *header = reinterpret_cast<size_t *>(block);
+			header[0] = size;
+			header[1] = 0;
+			if (global.tracking) {
+				header[1] = global.epoch;
+				++global.allocations;
+				global.allocated_bytes += size;
+				global.live_bytes      += size;
+				if (global.live_bytes > global.peak_bytes) global.peak_bytes = global.live_bytes;
+			}
+			return block + allocation_header;
+		}
+
+		void *allocate_or_throw(size_t size) {
+			for (;;) {
+				void *pointer = allocate(size);
+				if (pointer) return pointer;
+				std::new_handler handler = std::set_new_handler(nullptr);
+				std::set_new_handler(handler);
+				if (!handler) throw std::bad_alloc();
+				handler();
+			}
+		}
+
+		void deallocate(void *pointer) noexcept {
+			if (!pointer) return;
+			char *block = static_cast<char *>(pointer) - allocation_header;
+			size_t *header = reinterpret_cast<size_t *>(block);
+			// Blocks are only counted as freed by the test that allocated
+			// them, on the thread that allocated them.
+			if (header[1] != 0 && header[1] == global.epoch) global.live_bytes -= header[0];
+			std::free(block);
+		}
+
+	}
+#endif
+
+	// Helpers for writing JSON values.
+	namespace detail {
+
+		void append_json(std::string &out, const std::string &value) {
+			out += '"';
+			for (size_t i = 0; i < value.size(); ++i) {
+				unsigned char c = value[i];
+				switch (c) {
+					case '"':  out += "\\\""; break;
+					case '\\': out += "\\\\"; break;
+					case '\n': out += "\\n";  break;
+					case '\r': out += "\\r";  break;
+					case '\t': out += "\\t";  break;
+					default:
+						if (c < 0x20) {
+							char escape[8];
+							std::snprintf(escape, sizeof escape, "\\u%04x", c);
+							out += escape;
+						} else {
+							out += c;
+						}
+				}
+			}
+			out += '"';
+		}
+
+		void append_json(std::string &out, size_t value) {
+			char number[32];
+			std::snprintf(number, sizeof number, "%llu", static_cast<unsigned long long>(value));
+			out += number;
+		}
+
+		void append_json(std::string &out, double value) {
+			// JSON has no way to write infinities or NaNs.
+			if (!std::isfinite(value)) {
+				out += "null";
+				return;
+			}
+			char number[32];
+			std::snprintf(number, sizeof number, "%.9g", value);
+			out += number;
+		}
+
+		void append_json(std::string &out, bool value) {
+			out += value ? "true" : "false";
+		}
+
+		template <typename T>
+		void append_json(std::string &out, const char *key, const T &value) {
+			out += ",\"";
+			out += key;
+			out += "\":";
+			append_json(out, value);
+		}
+
+	}
+
+	// Implementation of the JSON Lines reporter.
+
+	JSON_Reporter::JSON_Reporter() {}
+
+	JSON_Reporter::~JSON_Reporter() {
+		flush();
+	}
+
+	void JSON_Reporter::begin_line(const char *event) {
+		buffer += "{\"event\":\"";
+		buffer += event;
+		buffer += '"';
+	}
+
+	void JSON_Reporter::begin_line(const char *event, const Test_Info &test_info) {
+		begin_line(event);
+		detail::append_json(buffer, "name", test_info.name);
+		detail::append_json(buffer, "file", test_info.file);
+		detail::append_json(buffer, "line", test_info.line);
+	}
+
+	// Finish the current line, writing the buffer out once it gets large.
+	void JSON_Reporter::end_line() {
+		buffer += "}\n";
+		if (buffer.size() >= 64 * 1024) {
+			std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+			buffer.clear();
+		}
+	}
+
+	void JSON_Reporter::report_test_count(size_t count) {
+		begin_line("count");
+		detail::append_json(buffer, "count", count);
+		end_line();
+	}
+
+	void JSON_Reporter::report_test_started(const Test_Info &test_info) {
+		begin_line("started", test_info);
+		end_line();
+	}
+
+	void JSON_Reporter::report_test_complete(const Test_Info &test_info) {
+		begin_line("complete", test_info);
+		detail::append_json(buffer, "passed",   test_info.passed);
+		detail::append_json(buffer, "aborted",  test_info.aborted);
+		detail::append_json(buffer, "duration", test_info.duration);
+		if (test_info.allocations.tracked) {
+			detail::append_json(buffer, "allocations",     test_info.allocations.count);
+			detail::append_json(buffer, "allocated_bytes", test_info.allocations.bytes);
+			detail::append_json(buffer, "peak_bytes",      test_info.allocations.peak_bytes);
+			detail::append_json(buffer, "leaked_bytes",    test_info.allocations.leaked_bytes);
+		}
+		end_line();
+	}
+
+	void JSON_Reporter::report_test_error(const Test_Info &test_info, const Error_Info &error_info) {
+		begin_line("error", test_info);
+		detail::append_json(buffer, "error_file", error_info.file);
+		detail::append_json(buffer, "error_line", error_info.line);
+		detail::append_json(buffer, "required",   error_info.required);
+		detail::append_json(buffer, "expression", error_info.expression);
+		end_line();
+	}
+
+	void JSON_Reporter::report_benchmark_result(const Test_Info &test_info, const Benchmark_Result &result) {
+		begin_line("benchmark", test_info);
+		detail::append_json(buffer, "iterations",       result.iterations);
+		detail::append_json(buffer, "repetitions",      result.repetitions);
+		detail::append_json(buffer, "mean",             result.mean);
+		detail::append_json(buffer, "median",           result.median);
+		detail::append_json(buffer, "stddev",           result.stddev);
+		detail::append_json(buffer, "min",              result.min);
+		detail::append_json(buffer, "max",              result.max);
+		detail::append_json(buffer, "items_per_second", result.items_per_second);
+		detail::append_json(buffer, "bytes_per_second", result.bytes_per_second);
+		end_line();
+	}
+
+	void JSON_Reporter::report_test_summary(const Test_Statistics &statistics) {
+		begin_line("summary");
+		detail::append_json(buffer, "count",    statistics.count);
+		detail::append_json(buffer, "started",  statistics.started);
+		detail::append_json(buffer, "complete", statistics.complete);
+		detail::append_json(buffer, "passed",   statistics.passed);
+		detail::append_json(buffer, "failed",   statistics.failed);
+		detail::append_json(buffer, "aborted",  statistics.aborted);
+		detail::append_json(buffer, "duration", statistics.duration);
+		end_line();
+		flush();
+	}
+
+	void JSON_Reporter::flush() {
+		if (!buffer.empty()) {
+			std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+			buffer.clear();
+		}
+		std::fflush(stdout);
+	}
+
+	// Implementation of the asynchronous reporter.
+
+	// An event waiting to be written. Tests are passed by pointer, since
+	// their Test_Info stays alive until the next flush; only the results,
+	// which change as the test runs, are copied.
+	struct Async_Reporter::Event {
+		enum Kind { count, started, complete, error, benchmark, summary };
+		Kind             kind;
+		size_t           test_count;
+		const Test_Info *test;
+		bool             passed;
+		bool             aborted;
+		double           duration;
+		Allocation_Info  allocations;
+		Error_Info       error_info;
+		Benchmark_Result benchmark_result;
+		Test_Statistics  statistics;
+	};
+
+	// A fixed-size ring of events with a single producer, the thread
+	// reporting events, and a single consumer, the writer thread. Each side
+	// only ever advances its own index, so no locks are needed while both
+	// are busy. A side that has to wait, the producer when the ring is full
+	// or the writer when it is empty, sleeps on a condition variable, and
+	// the other side only takes the lock to wake it when it's waiting.
+	struct Async_Reporter::Queue {
+
+		static const size_t capacity = 1024;
+
+		explicit Queue(Reporter &wrapped) :
+			reporter(wrapped),
+			events(capacity),
+			head(0),
+			tail(0),
+			flushed(0),
+			done(false),
+			producer_waiting(false),
+			writer_waiting(false),
+			test(nullptr)
+		{
+			thread = std::thread(&Queue::write, this);
+		}
+
+		~Queue() {
+			done = true;
+			wake();
+			thread.join();
+		}
+
+		// Claim the next free event, waiting for the writer if necessary.
+		Event &next() {
+			size_t index = head.load(std::memory_order_relaxed);
+			if (index - tail.load(std::memory_order_acquire) == capacity) {
+				std::unique_lock<std::mutex> lock(mutex);
+				producer_waiting = true;
+				while (index - tail.load() == capacity) changed.wait(lock);
+				producer_waiting = false;
+			}
+			return events[index % capacity];
+		}
+
+		// Fill in the test of the claimed event.
+		void set_test(Event &event, const Test_Info &test_info) {
+			event.test        = &test_info;
+			event.passed      = test_info.passed;
+			event.aborted     = test_info.aborted;
+			event.duration    = test_info.duration;
+			event.allocations = test_info.allocations;
+		}
+
+		// Hand the claimed event over to the writer.
+		void push() {
+			head.store(head.load(std::memory_order_relaxed) + 1);
+			if (writer_waiting.load()) wake();
+		}
+
+		// Wait until every pushed event has been written and flushed.
+		void drain() {
+			size_t index = head.load(std::memory_order_relaxed);
+			if (flushed.load(std::memory_order_acquire) != index) {
+				std::unique_lock<std::mutex> lock(mutex);
+				producer_waiting = true;
+				while (flushed.load() != index) changed.wait(lock);
+				producer_waiting = false;
+			}
+		}
+
+		// Wake whichever side is waiting. Taking the lock makes sure a
+		// waiter that has just seen nothing change is already asleep.
+		void wake() {
+			std::lock_guard<std::mutex> lock(mutex);
+			changed.notify_all();
+		}
+
+		// Writer thread: pass each batch of events on to the reporter, and
+		// flush it whenever there's nothing left to write.
+		void write() {
+			size_t index = 0;
+			for (;;) {
+				size_t end = head.load(std::memory_order_acquire);
+				if (index == end) {
+					if (flushed.load(std::memory_order_relaxed) != index) {
+						reporter.flush();
+						// Once flushed, a Test_Info may be reused for
+						// another test, so don't trust the copy any more.
+						test = nullptr;
+						flushed.store(index);
+						if (producer_waiting.load()) wake();
+					}
+					std::unique_lock<std::mutex> lock(mutex);
+					writer_waiting = true;
+					while (head.load() == index && !done.load()) changed.wait(lock);
+					writer_waiting = false;
+					if (head.load() == index) return;
+					continue;
+				}
+				for (; index != end; ++index) {
+					deliver(events[index % capacity]);
+					tail.store(index + 1);
+					if (producer_waiting.load()) wake();
+				}
+			}
+		}
+
+		// Get the test of an event as a Test_Info to pass on, copying the
+		// test's name and file only when it isn't the same test as before.
+		const Test_Info &test_info(const Event &event) {
+			if (event.test != test) {
+				test = event.test;
+				current.name = test->name;
+				current.file = test->file;
+				current.line = test->line;
+			}
+			current.passed      = event.passed;
+			current.aborted     = event.aborted;
+			current.duration    = event.duration;
+			current.allocations = event.allocations;
+			return current;
+		}
+
+		void deliver(const Event &event) {
+			switch (event.kind) {
+				case Event::count:     reporter.report_test_count(event.test_count); break;
+				case Event::started:   reporter.report_test_started(test_info(event)); break;
+				case Event::complete:  reporter.report_test_complete(test_info(event)); break;
+				case Event::error:     reporter.report_test_error(test_info(event), event.error_info); break;
+				case Event::benchmark: reporter.report_benchmark_result(test_info(event), event.benchmark_result); break;
+				case Event::summary:   reporter.report_test_summary(event.statistics); break;
+			}
+		}
+
+		Reporter                &reporter;
+		std::vector<Event>       events;
+		std::atomic<size_t>      head;    // Events pushed by the producer
+		std::atomic<size_t>      tail;    // Events written by the writer
+		std::atomic<size_t>      flushed; // Events written and flushed
+		std::atomic<bool>        done;
+		std::mutex               mutex;   // Held while deciding to wait
+		std::condition_variable  changed; // Signalled when a waiter should look again
+		std::atomic<bool>        producer_waiting;
+		std::atomic<bool>        writer_waiting;
+		const Test_Info         *test;    // Test last passed on by the writer
+		Test_Info                current; // Copy of it, given to the reporter
+		std::thread              thread;
+	};
+
+	Async_Reporter::Async_Reporter(Reporter &reporter) : queue(new Queue(reporter)) {}
+
+	Async_Reporter::~Async_Reporter() {
+		delete queue;
+	}
+
+	void Async_Reporter::report_test_count(size_t count) {
+		Event &event = queue->next();
+		event.kind       = Event::count;
+		event.test_count = count;
+		queue->push();
+	}
+
+	void Async_Reporter::report_test_started(const Test_Info &test_info) {
+		Event &event = queue->next();
+		event.kind = Event::started;
+		queue->set_test(event, test_info);
+		queue->push();
+	}
+
+	void Async_Reporter::report_test_complete(const Test_Info &test_info) {
+		Event &event = queue->next();
+		event.kind = Event::complete;
+		queue->set_test(event, test_info);
+		queue->push();
+	}
+
+	void Async_Reporter::report_test_error(const Test_Info &test_info, const Error_Info &error_info) {
+		Event &event = queue->next();
+		event.kind       = Event::error;
+		event.error_info = error_info;
+		queue->set_test(event, test_info);
+		queue->push();
+	}
+
+	void Async_Reporter::report_benchmark_result(const Test_Info &test_info, const Benchmark_Result &result) {
+		Event &event = queue->next();
+		event.kind             = Event::benchmark;
+		event.benchmark_result = result;
+		queue->set_test(event, test_info);
+		queue->push();
+	}
+
+	void Async_Reporter::report_test_summary(const Test_Statistics &statistics) {
+		Event &event = queue->next();
+		event.kind       = Event::summary;
+		event.statistics = statistics;
+		queue->push();
+		queue->drain();
+	}
+
+	void Async_Reporter::flush() {
+		queue->drain();
+	}
+
 }
+
+// Replace the global allocation functions when allocation tracking is
+// requested.
+#ifdef SCUTL_ALLOCATIONS
+
+void *operator new(std::size_t size) {
+	return scutl::detail::allocate_or_throw(size);
+}
+
+void *operator new[](std::size_t size) {
+	return scutl::detail::allocate_or_throw(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+	return scutl::detail::allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+	return scutl::detail::allocate(size);
+}
+
+void operator delete(void *pointer) noexcept {
+	scutl::detail::deallocate(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+	scutl::detail::deallocate(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+	scutl::detail::deallocate(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+	scutl::detail::deallocate(pointer);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *pointer, std::size_t) noexcept {
+	scutl::detail::deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+	scutl::detail::deallocate(pointer);
+}
+#endif
+
+#endif
 #endif
 
 // Implement the main function when requested.
@@ -792,9 +3980,29 @@ namespace scutl {
 #define SCUTL_REPORTER Default_Reporter
 #endif
 
-int main() {
+int main(int argc, char **argv) {
+	scutl::Run_Options options;
+#ifdef SCUTL_JOBS
+	options.jobs = SCUTL_JOBS;
+#endif
+#ifdef SCUTL_ISOLATE
+	options.isolate = true;
+#endif
+#ifdef SCUTL_TIMEOUT
+	options.timeout = SCUTL_TIMEOUT;
+#endif
+#ifdef SCUTL_TIMING_CACHE
+	options.timing_cache = SCUTL_TIMING_CACHE;
+#endif
+	int status = scutl::parse_arguments(argc, argv, options);
+	if (status >= 0) return status;
 	scutl::SCUTL_REPORTER reporter;
-	bool passed = scutl::run(reporter);
+#ifdef SCUTL_ASYNC
+	scutl::Async_Reporter async_reporter(reporter);
+	bool passed = scutl::run(async_reporter, options);
+#else
+	bool passed = scutl::run(reporter, options);
+#endif
 	return !passed;
 }
 #endif
@@ -1,4 +1,5 @@
 #include <scutl.h++>
+#include <iostream>
 
 TEST(EXPECT_true_then_false) {
 	EXPECT(true);
@@ -35,3 +36,10 @@ TEST(call_expect_from_a_function) {
 	int x = 1;
 	function_calling_expect(x);
 }
+
+TEST(EXPECT_false_three_times) {
+	std::cerr << "Expect three EXPECT(false) errors\n";
+	for (int i = 0; i < 3; ++i) {
+		EXPECT(false);
+	}
+}
@@ -1,4 +1,5 @@
 #include <scutl.h++>
+#include <iostream>
 
 TEST(REQUIRE_true_then_false) {
 	REQUIRE(true);
@@ -35,3 +36,10 @@ TEST(call_require_from_a_function) {
 	int x = 1;
 	function_calling_require(x);
 }
+
+TEST(REQUIRE_false_after_EXPECT_false_twice) {
+	std::cerr << "Expect two EXPECT(false) errors, then one REQUIRE(false) error\n";
+	EXPECT(false);
+	EXPECT(false);
+	REQUIRE(false);
+}
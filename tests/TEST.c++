@@ -9,3 +9,15 @@ TEST(duplicate_test_names_are_ok) {}
 namespace xyz {
 	TEST(TEST_works_in_an_arbitrary_namespace) {}
 }
+
+namespace user_names {
+	bool ran = false;
+	void run() { ran = true; }
+	int registration = 1;
+
+	TEST(TEST_bodies_see_user_names) {
+		run();
+		REQUIRE(ran);
+		REQUIRE(registration == 1);
+	}
+}
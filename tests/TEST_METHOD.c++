@@ -48,3 +48,13 @@ namespace Increment_Decrement {
 		EXPECT(x == 8);
 	}
 }
+
+namespace Over_Aligned {
+	struct Fixture {
+		alignas(64) char data[64];
+	};
+
+	TEST_METHOD(Fixture, over_aligned_fixture_is_aligned) { REQUIRE(reinterpret_cast<size_t>(data) % 64 == 0); }
+	TEST_METHOD(Fixture, over_aligned_fixture_is_aligned) { REQUIRE(reinterpret_cast<size_t>(data) % 64 == 0); }
+	TEST_METHOD(Fixture, over_aligned_fixture_is_aligned) { REQUIRE(reinterpret_cast<size_t>(data) % 64 == 0); }
+}
@@ -0,0 +1,91 @@
+#include <scutl.h++>
+#include <iostream>
+#include <stdexcept>
+
+namespace Shared_Suite {
+	size_t created = 0;
+
+	struct Shared {
+		Shared() : x(100) { ++created; }
+		~Shared() { std::cerr << "Expect the Shared suite fixture to be destroyed\n"; }
+		size_t x;
+	};
+
+	struct Fixture {
+		Fixture() : shared(SUITE_FIXTURE(Shared)), y(1) {}
+		const Shared &shared;
+		size_t y;
+	};
+
+	TEST_SUITE_METHOD(Shared, Fixture, suite_fixture_is_shared) {
+		REQUIRE(shared.x == 100);
+		REQUIRE(created == 1);
+		REQUIRE(y++ == 1);
+	}
+
+	TEST(suite_tests_are_grouped_before_this) {}
+
+	TEST_SUITE_METHOD(Shared, Fixture, suite_fixture_is_shared) {
+		REQUIRE(&shared == &SUITE_FIXTURE(Shared));
+		REQUIRE(created == 1);
+		REQUIRE(y++ == 1);
+	}
+}
+
+namespace Broken_Suite {
+	struct Broken {
+		Broken() {
+			std::cerr << "Expect two suite fixture setup failed errors\n";
+			throw std::runtime_error("no database");
+		}
+	};
+
+	struct Empty {};
+
+	TEST_SUITE_METHOD(Broken, Empty, suite_fixture_setup_fails) {
+		std::cerr << "Failed to abort test after suite fixture setup failed\n";
+	}
+
+	TEST_SUITE_METHOD(Broken, Empty, suite_fixture_setup_fails) {
+		std::cerr << "Failed to abort test after suite fixture setup failed\n";
+	}
+}
+
+namespace Required_Suite {
+	struct Required {
+		Required() {
+			std::cerr << "Expect the failed REQUIRE to be reported once, then a suite fixture setup failed error\n";
+			REQUIRE(false);
+		}
+	};
+
+	struct Empty {};
+
+	TEST_SUITE_METHOD(Required, Empty, suite_fixture_require_fails) {
+		std::cerr << "Failed to abort test after suite fixture REQUIRE failed\n";
+	}
+
+	TEST_SUITE_METHOD(Required, Empty, suite_fixture_require_fails) {
+		std::cerr << "Failed to abort test after suite fixture setup failed\n";
+	}
+}
+
+TEST(suite_fixture_outside_of_suite_fails) {
+	const Shared_Suite::Shared &shared = SUITE_FIXTURE(Shared_Suite::Shared);
+	std::cerr << "Failed to abort test using a suite fixture outside of its suite: " << shared.x << "\n";
+}
+
+namespace Over_Aligned_Suite {
+	struct Aligned {
+		alignas(64) char data[64];
+	};
+
+	struct Fixture {
+		Fixture() : aligned(SUITE_FIXTURE(Aligned)) {}
+		const Aligned &aligned;
+	};
+
+	TEST_SUITE_METHOD(Aligned, Fixture, over_aligned_suite_fixture_is_aligned) {
+		REQUIRE(reinterpret_cast<size_t>(aligned.data) % 64 == 0);
+	}
+}
@@ -0,0 +1,67 @@
+#define SCUTL_ALLOCATIONS
+#define SCUTL_MAIN
+#include <scutl.h++>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+TEST(no_allocations_passing) {
+	EXPECT_NO_ALLOCATIONS {
+		int x = 1;
+		scutl::do_not_optimize(x);
+	}
+}
+
+TEST(no_allocations_failing) {
+	std::cerr << "Expect an EXPECT_NO_ALLOCATIONS error\n";
+	EXPECT_NO_ALLOCATIONS {
+		std::vector<int> v(10);
+		scutl::do_not_optimize(v);
+	}
+}
+
+TEST(max_allocations_passing) {
+	EXPECT_MAX_ALLOCATIONS(1) {
+		std::unique_ptr<int> p(new int(1));
+		scutl::do_not_optimize(*p);
+	}
+}
+
+TEST(max_allocations_failing) {
+	std::cerr << "Expect a REQUIRE_MAX_ALLOCATIONS(1) error\n";
+	REQUIRE_MAX_ALLOCATIONS(1) {
+		std::unique_ptr<int> p(new int(1));
+		std::unique_ptr<int> q(new int(2));
+		scutl::do_not_optimize(*p + *q);
+	}
+	std::cerr << "Failed to abort test after REQUIRE_MAX_ALLOCATIONS\n";
+}
+
+TEST(allocations_are_counted) {
+	std::unique_ptr<int> a(new int(1));
+	std::unique_ptr<int> b(new int(2));
+	std::unique_ptr<int> c(new int(3));
+	a.reset();
+	std::unique_ptr<char[]> d(new char[100]);
+}
+
+int *leaked = nullptr;
+
+TEST(leaks_are_counted) {
+	leaked = new int[4];
+}
+
+TEST(thrown_exceptions_are_not_leaks) {
+	throw std::runtime_error("an exception message too long for small strings");
+}
+
+struct Fixture {
+	Fixture() : data(new int[8]) {}
+	~Fixture() { delete[] data; }
+	int *data;
+};
+
+TEST_METHOD(Fixture, fixtures_are_counted) {
+	data[0] = 1;
+}
@@ -0,0 +1,66 @@
+#define SCUTL_LIBRARY
+#include <scutl.h++>
+#include <iostream>
+#include <vector>
+
+// Timings vary from run to run, so this reporter only prints whether each
+// benchmark result is self-consistent.
+struct Checking_Reporter : scutl::Default_Reporter {
+	virtual void report_benchmark_result(const scutl::Test_Info &test_info, const scutl::Benchmark_Result &result) {
+		std::cout
+			<< test_info.name << ": "
+			<< (result.iterations >= 1 ? "iterations ok" : "NO ITERATIONS") << ", "
+			<< (result.repetitions == 5 ? "repetitions ok" : "WRONG REPETITIONS") << ", "
+			<< (
+				result.min <= result.median && result.median <= result.max &&
+				result.min <= result.mean && result.mean <= result.max &&
+				result.stddev >= 0
+				? "statistics ordered" : "STATISTICS UNORDERED"
+			) << ", "
+			<< (result.items_per_second > 0 ? "items/s" : "no items/s") << ", "
+			<< (result.bytes_per_second > 0 ? "bytes/s" : "no bytes/s") << "\n"
+		;
+	}
+};
+
+BENCHMARK(empty_body) {}
+
+BENCHMARK(sum_with_throughput) {
+	std::vector<int> data(64, 1);
+	scutl::set_items_per_iteration(data.size());
+	scutl::set_bytes_per_iteration(data.size() * sizeof(int));
+	int sum = 0;
+	for (size_t i = 0; i < data.size(); ++i) sum += data[i];
+	scutl::do_not_optimize(sum);
+	scutl::clobber_memory();
+}
+
+struct Counted_Fixture {
+	static int constructed;
+	Counted_Fixture() { ++constructed; }
+};
+int Counted_Fixture::constructed = 0;
+
+BENCHMARK_METHOD(Counted_Fixture, fixture_is_outside_timed_region) {
+	scutl::do_not_optimize(constructed);
+}
+
+TEST(fixture_was_constructed_once) {
+	EXPECT(Counted_Fixture::constructed == 1);
+}
+
+BENCHMARK(failing_benchmark) {
+	REQUIRE(false);
+}
+
+BENCHMARK(expect_failure_is_reported_once) {
+	EXPECT(false);
+}
+
+int main() {
+	Checking_Reporter reporter;
+	scutl::Run_Options options;
+	options.benchmark_time        = 0.001;
+	options.benchmark_repetitions = 5;
+	return !scutl::run(reporter, options);
+}
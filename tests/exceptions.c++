@@ -1,4 +1,5 @@
 #include <scutl.h++>
+#include <iostream>
 #include <stdexcept>
 
 TEST(no_exception) {
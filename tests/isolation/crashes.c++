@@ -0,0 +1,43 @@
+#define SCUTL_ISOLATE
+#define SCUTL_JOBS 2
+#define SCUTL_TIMEOUT 0.5
+#define SCUTL_MAIN
+#include <scutl.h++>
+#include <csignal>
+#include <cstdlib>
+
+TEST(passes_before_crashes) {
+	EXPECT(true);
+}
+
+TEST(segmentation_fault) {
+	std::raise(SIGSEGV);
+}
+
+TEST(abort_after_an_error) {
+	EXPECT(false);
+	std::abort();
+}
+
+TEST(infinite_loop) {
+	volatile bool forever = true;
+	while (forever) {}
+}
+
+TEST(exit_from_a_test) {
+	std::exit(3);
+}
+
+TEST(passes_after_crashes) {
+	EXPECT(true);
+}
+
+TEST(fails_after_crashes) {
+	REQUIRE(false);
+}
+
+TEST(SIGPIPE_is_not_ignored) {
+	void (*handler)(int) = std::signal(SIGPIPE, SIG_DFL);
+	std::signal(SIGPIPE, handler);
+	REQUIRE(handler == SIG_DFL);
+}
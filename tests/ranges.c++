@@ -0,0 +1,88 @@
+#include <scutl.h++>
+#include <array>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+TEST(EXPECT_RANGE_EQ_passing) {
+	std::vector<int> a(1000, 7);
+	std::vector<int> b(1000, 7);
+	int c[] = { 1, 2, 3 };
+	std::array<int, 3> d = {{ 1, 2, 3 }};
+	std::list<int> e(c, c + 3);
+	std::string f = "abc";
+	std::vector<char> g(f.begin(), f.end());
+	EXPECT_RANGE_EQ(a, b);
+	EXPECT_RANGE_EQ(c, d);
+	EXPECT_RANGE_EQ(d, e);
+	EXPECT_RANGE_EQ(f, g);
+	EXPECT_RANGE_EQ(std::vector<int>(), std::list<int>());
+}
+
+TEST(EXPECT_RANGE_EQ_failing) {
+	std::vector<int> a(1000, 7);
+	std::vector<int> b(1000, 7);
+	b[17] = 5;
+	b[500] = 5;
+	b[999] = 5;
+	std::cerr << "Expect an EXPECT_RANGE_EQ(a, b) error, 3 of 1000 differ\n";
+	EXPECT_RANGE_EQ(a, b);
+	std::list<unsigned> c(4, 1);
+	unsigned d[] = { 1, 1, 2 };
+	std::cerr << "Expect an EXPECT_RANGE_EQ(c, d) error, sizes and 1 of 3 differ\n";
+	EXPECT_RANGE_EQ(c, d);
+	std::vector<std::string> e(2, "x");
+	std::vector<std::string> f(2, "y");
+	std::cerr << "Expect an EXPECT_RANGE_EQ(e, f) error, values not shown\n";
+	EXPECT_RANGE_EQ(e, f);
+}
+
+TEST(REQUIRE_RANGE_EQ_failing) {
+	std::vector<double> a(3, 0.5);
+	std::vector<double> b(3, 0.5);
+	b[1] = 0.25;
+	std::cerr << "Expect a REQUIRE_RANGE_EQ(a, b) error\n";
+	REQUIRE_RANGE_EQ(a, b);
+	std::cerr << "Failed to abort test after REQUIRE_RANGE_EQ\n";
+}
+
+TEST(EXPECT_NEAR_RANGE_passing) {
+	std::vector<double> a(100, 1.0);
+	std::vector<double> b(100, 1.0 + 1e-9);
+	EXPECT_NEAR_RANGE(a, b, 1e-6);
+}
+
+TEST(EXPECT_NEAR_RANGE_failing) {
+	std::vector<double> a(100, 1.0);
+	std::vector<double> b(100, 1.0);
+	b[42] = 1.5;
+	std::cerr << "Expect an EXPECT_NEAR_RANGE(a, b, 0.25) error\n";
+	EXPECT_NEAR_RANGE(a, b, 0.25);
+}
+
+TEST(EXPECT_ALL_passing) {
+	std::vector<int> a(100, 2);
+	EXPECT_ALL(a, [](int x) { return x % 2 == 0; });
+}
+
+TEST(EXPECT_ALL_failing) {
+	std::vector<int> a(100, 2);
+	a[3] = -1;
+	std::cerr << "Expect an EXPECT_ALL error, 1 of 100 fail\n";
+	EXPECT_ALL(a, [](int x) { return x >= 0; });
+}
+
+TEST(REQUIRE_ALL_failing) {
+	std::list<int> a(5, -3);
+	std::cerr << "Expect a REQUIRE_ALL error, 5 of 5 fail\n";
+	REQUIRE_ALL(a, [](int x) { return x >= 0; });
+	std::cerr << "Failed to abort test after REQUIRE_ALL\n";
+}
+
+TEST(EXPECT_ALL_stateful_predicate_failing) {
+	std::vector<int> a = {0, 1, 2, 99, 4, 5};
+	int next = 0;
+	std::cerr << "Expect an EXPECT_ALL error, first at [3]\n";
+	EXPECT_ALL(a, [&](int x) { return x == next++; });
+}
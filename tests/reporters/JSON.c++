@@ -0,0 +1,3 @@
+#define SCUTL_REPORTER JSON_Reporter
+#define SCUTL_ASYNC
+#include <scutl.h++>